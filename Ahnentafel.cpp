@@ -0,0 +1,97 @@
+#include "Ahnentafel.hpp"
+#include "FamilyTree.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* fatherOf / motherOf / childOf - Ahnentafel number arithmetic.
+* param 1: number - the Ahnentafel number of a person.
+* return value: the Ahnentafel number of the father/mother/child of that person.
+*/
+uint64_t AhnentafelIndex::fatherOf(uint64_t number){
+    return number << 1;
+}
+
+uint64_t AhnentafelIndex::motherOf(uint64_t number){
+    return (number << 1) | 1;
+}
+
+uint64_t AhnentafelIndex::childOf(uint64_t number){
+    return number >> 1;
+}
+
+/*
+* relationOf - get relation information of a person by his Ahnentafel number.
+* param 1: number - an Ahnentafel number (must not be 0).
+* return value: relation_data - the generation is the position of the highest set bit, the side is the lowest bit.
+*/
+relation_data AhnentafelIndex::relationOf(uint64_t number){
+    relation_data data;
+    data.valid = number != 0;
+    data.depth = 63 - __builtin_clzll(number | 1);
+    if(data.depth == 0){
+        data.pos = self;
+    }else{
+        data.pos = (number & 1) ? mother_pos : father_pos;
+    }
+    return data;
+}
+
+/*
+* add - registers a person under his Ahnentafel number.
+* param 1: number - the person's Ahnentafel number.
+* param 2: person - the person's node.
+*/
+void AhnentafelIndex::add(uint64_t number, node *person){
+    people[number] = person;
+    relation_data data = relationOf(number);
+    if(data.depth > 0){
+        vector<set<uint64_t>> &side = data.pos == father_pos ? fathers : mothers;
+        if((int)side.size() <= data.depth){
+            side.resize(data.depth + 1);
+        }
+        side.at(data.depth).insert(number);
+    }
+}
+
+/*
+* remove - unregisters a person.
+* param 1: number - the person's Ahnentafel number.
+*/
+void AhnentafelIndex::remove(uint64_t number){
+    people.erase(number);
+    relation_data data = relationOf(number);
+    if(data.depth > 0){
+        vector<set<uint64_t>> &side = data.pos == father_pos ? fathers : mothers;
+        if(data.depth < (int)side.size()){
+            side.at(data.depth).erase(number);
+        }
+    }
+}
+
+/*
+* at - get a person by Ahnentafel number.
+* param 1: number - an Ahnentafel number.
+* return value: node* - the person Or NULL if nobody has this number.
+*/
+node* AhnentafelIndex::at(uint64_t number) const{
+    auto entry = people.find(number);
+    return entry == people.end() ? NULL : entry->second;
+}
+
+/*
+* first - get the first person (in preorder) of a given generation and side.
+* param 1: data - relation data object (depth must not exceed MAX_DEPTH).
+* return value: node* - the person with the smallest matching number Or NULL in case of no match.
+*/
+node* AhnentafelIndex::first(relation_data data) const{
+    if(data.depth == 0){
+        return at(1);
+    }
+    const vector<set<uint64_t>> &side = data.pos == father_pos ? fathers : mothers;
+    if(data.depth >= (int)side.size() || side.at(data.depth).empty()){
+        return NULL;
+    }
+    return at(*side.at(data.depth).begin());
+}
@@ -0,0 +1,43 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "Relation.hpp"
+using namespace std;
+
+struct node;
+
+namespace family{
+    /*
+    * AhnentafelIndex - numbers people Ahnentafel style: the root is 1, the father of k is 2k and the mother of k is 2k+1.
+    * Generation and side of a person are arithmetic on the number, and every generation keeps the numbers of its fathers
+    * and mothers ordered, so the smallest one (which is also the first one in preorder) is found without a traversal.
+    * Numbers are 64 bit, so only the first MAX_DEPTH generations are numbered.
+    */
+    class AhnentafelIndex{
+    private:
+        /*Private variables*/
+        unordered_map<uint64_t, node*> people;  // Ahnentafel number -> person.
+        vector<set<uint64_t>> fathers;           // Per generation, the numbers of the fathers present in the tree.
+        vector<set<uint64_t>> mothers;           // Per generation, the numbers of the mothers present in the tree.
+
+    public:
+        static const int MAX_DEPTH = 63;
+
+        static uint64_t fatherOf(uint64_t number);
+        static uint64_t motherOf(uint64_t number);
+        static uint64_t childOf(uint64_t number);
+        static relation_data relationOf(uint64_t number);
+
+        void add(uint64_t number, node *person);
+        void remove(uint64_t number);
+        node* at(uint64_t number) const;
+        node* first(relation_data data) const;
+    };
+}
@@ -0,0 +1,219 @@
+#include <unordered_map>
+#include "CompactTree.hpp"
+#include "OutputBuffer.hpp"
+#include "Traversal.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* Outline constructor - copies a tree into compact preorder arrays.
+* param 1: source - the tree to copy.
+*/
+CompactTree::CompactTree(const Tree &source){
+    unordered_map<const node*, uint32_t> indexOf;
+    size_t people = source.nodes.size();
+    father.reserve(people);
+    mother.reserve(people);
+    child.reserve(people);
+    relationKey.reserve(people);
+    fingerprint.reserve(people);
+    nameRef.reserve(people + 1);
+    indexOf.reserve(people);
+
+    preorder(source.root, [&](node *person){
+        uint32_t i = father.size();
+        indexOf[person] = i;
+        father.push_back(NONE);
+        mother.push_back(NONE);
+        child.push_back(NONE);
+        relation_data data;
+        data.valid = true;
+        data.depth = person->depth;
+        data.pos = person->pos;
+        relationKey.push_back(keyOf(data));
+        string_view name = source.nameOf(person);
+        fingerprint.push_back(fingerprintOf(name));
+        nameRef.push_back(names.size());
+        names += name;
+        if(person->child != NULL){
+            uint32_t c = indexOf.at(person->child);
+            child.at(i) = c;
+            (person->pos == father_pos ? father : mother).at(c) = i;
+        }
+        return false;
+    });
+    nameRef.push_back(names.size());
+}
+
+/*
+* keyOf - the relationKey of a relation: depth*2, plus one for the mother's side.
+*/
+uint32_t CompactTree::keyOf(relation_data data){
+    return (uint32_t)data.depth * 2 + (data.pos == mother_pos ? 1 : 0);
+}
+
+/*
+* size - the number of people.
+*/
+size_t CompactTree::size() const{
+    return father.size();
+}
+
+/*
+* nameOf / fatherOf / motherOf / childOf - access a person by index (links are NONE when missing).
+*/
+string_view CompactTree::nameOf(uint32_t person) const{
+    return string_view(names).substr(nameRef[person], nameRef[person + 1] - nameRef[person]);
+}
+
+uint32_t CompactTree::fatherOf(uint32_t person) const{
+    return father[person];
+}
+
+uint32_t CompactTree::motherOf(uint32_t person) const{
+    return mother[person];
+}
+
+uint32_t CompactTree::childOf(uint32_t person) const{
+    return child[person];
+}
+
+/*
+* relationOf - relation information of a person.
+* param 1: person - an index.
+*/
+relation_data CompactTree::relationOf(uint32_t person) const{
+    relation_data data;
+    data.valid = true;
+    data.depth = relationKey[person] / 2;
+    data.pos = data.depth == 0 ? self : (relationKey[person] & 1) ? mother_pos : father_pos;
+    return data;
+}
+
+static const uint32_t SCAN_BLOCK = 16; // Fingerprints tested per block (a branch free loop the compiler vectorizes).
+
+/*
+* search - a sequential scan for a name. blocks of fingerprints are tested without branches,
+* names are compared only inside a block that holds a matching fingerprint.
+* param 1: who - the person who need to be found.
+* return value: the index of the first person in preorder with this name Or NONE.
+*/
+uint32_t CompactTree::search(string_view who) const{
+    uint32_t wanted = fingerprintOf(who);
+    const uint32_t *prints = fingerprint.data();
+    uint32_t people = fingerprint.size();
+    for(uint32_t block = 0; block < people; block += SCAN_BLOCK){
+        uint32_t last = people - block < SCAN_BLOCK ? people : block + SCAN_BLOCK;
+        bool hit = false;
+        if(last - block == SCAN_BLOCK){
+            for(uint32_t i = 0; i < SCAN_BLOCK; i++){
+                hit |= prints[block + i] == wanted;
+            }
+        }else{
+            hit = true; // The tail is checked one by one.
+        }
+        if(!hit){
+            continue;
+        }
+        for(uint32_t i = block; i < last; i++){
+            if(prints[i] == wanted && nameOf(i) == who){
+                return i;
+            }
+        }
+    }
+    return NONE;
+}
+
+/*
+* search - a sequential scan for a relation.
+* param 1: data - relation data object.
+* return value: the index of the first person in preorder matching the relation Or NONE.
+*/
+uint32_t CompactTree::search(relation_data data) const{
+    uint32_t key = keyOf(data);
+    for(uint32_t i = 0; i < relationKey.size(); i++){
+        if(relationKey[i] == key){
+            return i;
+        }
+    }
+    return NONE;
+}
+
+/*
+* display - prints the tree in preorder and writes relevant relation info (same output as Tree::display).
+*/
+void CompactTree::display() const{
+    display(cout);
+    cout.flush();
+}
+
+/*
+* display - writes the tree to a stream, buffered and without flushing it (see Tree::display).
+*/
+void CompactTree::display(ostream &out) const{
+    OutputBuffer text(out);
+    for(uint32_t i = 0; i < father.size(); i++){
+        if(child[i] == NONE){
+            text << nameOf(i) << '\n';
+        }else{
+            text << nameOf(child[i]) << "'s " << (relationKey[i] & 1 ? "mother" : "father") << ": " << nameOf(i) << '\n';
+        }
+    }
+}
+
+/*
+* relation - get relation information (father/mother...granfather..).
+* param 1: who - a name of person.
+* return value: string which represents a relation Or "unrelated".
+*/
+string CompactTree::relation(string_view who) const{
+    uint32_t person = search(who);
+    if(person == NONE){
+        relation_data data;
+        data.valid = false;
+        return relationToString(data);
+    }
+    return relationToString(relationOf(person));
+}
+
+/*
+* relation - writes relation information into a caller provided buffer (see writeRelation).
+*/
+size_t CompactTree::relation(string_view who, char *buffer, size_t size) const{
+    uint32_t person = search(who);
+    relation_data data;
+    data.valid = false;
+    return writeRelation(person == NONE ? data : relationOf(person), buffer, size);
+}
+
+/*
+* tryFind - search person's name by given relation type, without throwing.
+* param 1: relation - a relation type (Example: "grandfather").
+* return value: find_result - the name on success, otherwise status::bad_relation or status::relation_not_found.
+*/
+find_result CompactTree::tryFind(string_view relation) const{
+    find_result result;
+    relation_data data = parseRelation(relation);
+    if(!data.valid){
+        result.code = status::bad_relation;
+        return result;
+    }
+    uint32_t person = search(data);
+    result.code = person == NONE ? status::relation_not_found : status::ok;
+    if(person != NONE){
+        result.name = nameOf(person);
+    }
+    return result;
+}
+
+/*
+* find - search person's name by given relation type.
+* param 1: relation - a relation type (Example: "grandfather").
+* return value: string (name).
+*/
+string CompactTree::find(string_view relation) const{
+    find_result result = tryFind(relation);
+    throwIfFailed(result.code);
+    return string(result.name);
+}
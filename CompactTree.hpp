@@ -0,0 +1,59 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FamilyTree.hpp"
+using namespace std;
+
+namespace family{
+    /*
+    * CompactTree - a read only copy of a Tree in structure-of-arrays form.
+    * People are stored in preorder and referenced by 32 bit indices, so the links of a person take 12 bytes instead of 24,
+    * a subtree is a contiguous range and every scan (by name or by relation) walks the arrays sequentially.
+    * Since the layout is preorder, the first match of a scan is the same person the Tree finds,
+    * a repeated name is resolved in both to its first person in preorder (not the first one added).
+    * A name scan compares 32 bit fingerprints of the names in blocks, and touches the names only on a fingerprint hit.
+    */
+    class CompactTree{
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+    private:
+        /*Private variables*/
+        vector<uint32_t> father;      // Index of the father of every person Or NONE.
+        vector<uint32_t> mother;      // Index of the mother of every person Or NONE.
+        vector<uint32_t> child;       // Index of the child of every person Or NONE (for the root).
+        vector<uint32_t> relationKey; // depth*2 + 1 for mothers, depth*2 for fathers (and 0 for the root).
+        vector<uint32_t> fingerprint; // fingerprintOf() the name of every person.
+        vector<uint32_t> nameRef;     // Offset of every name in 'names', the name of i ends where the name of i+1 starts.
+        string names;                 // All names, back to back.
+
+        /*Private methods*/
+        static uint32_t keyOf(relation_data data);
+        uint32_t search(relation_data data) const;
+
+    public:
+        CompactTree(const Tree &source);
+
+        size_t size() const;
+        string_view nameOf(uint32_t person) const;
+        uint32_t fatherOf(uint32_t person) const;
+        uint32_t motherOf(uint32_t person) const;
+        uint32_t childOf(uint32_t person) const;
+        relation_data relationOf(uint32_t person) const;
+        uint32_t search(string_view who) const;
+
+        void display() const;
+        void display(ostream &out) const;
+        string relation(string_view who) const;
+        size_t relation(string_view who, char *buffer, size_t size) const;
+        find_result tryFind(string_view relation) const;
+        string find(string_view relation) const;
+    };
+}
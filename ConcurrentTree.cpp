@@ -0,0 +1,293 @@
+#include <atomic>
+#include "ConcurrentTree.hpp"
+#include "Traversal.hpp"
+
+using namespace std;
+using namespace family;
+
+static const size_t REMOVE_SLICE = 1024; // Removed people reclaimed per exclusive lock, by compact().
+
+/*
+* Outline constructor - creates a thread safe tree with youngest person as root.
+* param 1: root - the youngest person.
+* param 2: engine - the storage engine (linked by default).
+* param 3: mode - the way removed people are freed (immediate by default).
+* param 4: adding - the way fathers and mothers are added (exclusive by default).
+*/
+ConcurrentTree::ConcurrentTree(string_view root, storage engine, reclamation mode, insertion adding)
+    : tree(root, engine), mode(mode), adding(engine == storage::linked ? adding : insertion::exclusive){
+    if(mode == reclamation::epoch){
+        tree.retiring = &reclaimed;
+    }
+}
+
+/*
+* readNames - locks the name pool and the name index for reading, when concurrent adds may be writing them.
+*/
+shared_lock<shared_mutex> ConcurrentTree::readNames() const{
+    return adding == insertion::concurrent ? shared_lock<shared_mutex>(naming) : shared_lock<shared_mutex>();
+}
+
+/*
+* insert - the add of the concurrent insertion: a compare and swap of the empty father/mother slot.
+* The slot is the only link which changes, so adds to different people never wait for each other's links,
+* and of two adds to the same slot the one whose swap fails reports status::already_exist.
+* Only interning a new name and indexing the parent take the name lock exclusively, and the node comes from
+* the arena under a lock of its own. Removals are kept out by holding the writer lock shared.
+* param 1: to - someone to add father/mother to.
+* param 2: name - the parent's name.
+* param 3: pos - father_pos or mother_pos.
+* return value: status::ok, status::person_not_found or status::already_exist.
+*/
+status ConcurrentTree::insert(string_view to, string_view name, position pos){
+    shared_lock<shared_mutex> serial(writing);
+    node *son;
+    uint32_t symbol;
+    {
+        shared_lock<shared_mutex> reading(naming);
+        son = tree.search(to);
+        symbol = tree.symbols->find(name);
+    }
+    if(son == NULL){
+        return status::person_not_found;
+    }
+    atomic_ref<node*> slot(pos == father_pos ? son->father : son->mother);
+    if(slot.load(memory_order_acquire) != NULL){
+        return status::already_exist;
+    }
+    if(symbol == SymbolTable::NONE){
+        lock_guard<shared_mutex> interning(naming); // The name must be readable before the parent is published.
+        symbol = tree.symbols->intern(name);
+    }
+    node *parent;
+    {
+        lock_guard<mutex> growing(allocating);
+        parent = tree.nodes.allocate(symbol);
+    }
+    parent->depth = son->depth + 1;
+    parent->pos = pos;
+    parent->number = 0;
+    parent->child = son;
+    node *empty = NULL;
+    if(!slot.compare_exchange_strong(empty, parent, memory_order_release, memory_order_relaxed)){
+        lock_guard<mutex> growing(allocating);
+        tree.nodes.release(parent);
+        return status::already_exist;
+    }
+    lock_guard<shared_mutex> indexing(naming);
+    tree.addToIndex(parent);
+    return status::ok;
+}
+
+/*
+* reclaim - returns to the arena the retired nodes which no reader can see anymore.
+* The caller holds the writer lock (readers never touch the arena, so they aren't blocked).
+*/
+void ConcurrentTree::reclaim(){
+    size_t kept = 0;
+    for(size_t i = 0; i < retired.size(); i++){
+        if(epochs.safe(retired[i].first)){
+            for(node *person : retired[i].second){
+                tree.nodes.release(person);
+            }
+        }else if(kept++ != i){
+            retired[kept - 1] = move(retired[i]);
+        }
+    }
+    retired.resize(kept);
+}
+
+/*
+* retire - retires the nodes Tree::reclaim handed over since the last call, in the epoch mode.
+* The caller holds the writer lock.
+*/
+void ConcurrentTree::retire(){
+    if(!reclaimed.empty()){
+        retired.emplace_back(epochs.retire(), move(reclaimed));
+        reclaimed.clear();
+    }
+}
+
+/*
+* walk - a preorder search by relation which loads every link atomically, so it runs without the lock.
+* The caller must be inside the epoch domain or hold the lock.
+* param 1: data - relation data object.
+* return value: the first person in preorder matching the relation Or NULL.
+*/
+node* ConcurrentTree::walk(relation_data data) const{
+    NodeStack stack;
+    stack.push(tree.root);
+    while(!stack.empty()){
+        node *current = stack.pop();
+        if(current->depth == data.depth && current->pos == data.pos){
+            return current;
+        }
+        if(current->depth < data.depth){
+            node *mother = loadLink(current->mother);
+            node *father = loadLink(current->father);
+            if(mother != NULL){
+                stack.push(mother);
+            }
+            if(father != NULL){
+                stack.push(father);
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+* resultOf - the find_result of a walk, the caller holds the lock.
+* param 1: found - the person found Or NULL.
+*/
+find_result ConcurrentTree::resultOf(node *found) const{
+    find_result result;
+    result.code = found != NULL ? status::ok : status::relation_not_found;
+    if(found != NULL){
+        shared_lock<shared_mutex> names = readNames();
+        result.name = tree.nameOf(found);
+    }
+    return result;
+}
+
+/*
+* addFather / addMother / remove - the throwing API of Tree, each call holding the lock exclusively
+* (except for the adds of the concurrent insertion).
+*/
+ConcurrentTree& ConcurrentTree::addFather(string_view to, string &&name){
+    if(adding == insertion::concurrent){
+        throwIfFailed(insert(to, name, father_pos));
+    }else{
+        throwIfFailed(write([&](){ return tree.tryAddFather(to, move(name)); }));
+    }
+    return *this;
+}
+
+ConcurrentTree& ConcurrentTree::addFather(string_view to, string_view name){
+    throwIfFailed(tryAddFather(to, name));
+    return *this;
+}
+
+ConcurrentTree& ConcurrentTree::addFather(string_view to, const char *name){
+    return addFather(to, string_view(name));
+}
+
+ConcurrentTree& ConcurrentTree::addMother(string_view to, string &&name){
+    if(adding == insertion::concurrent){
+        throwIfFailed(insert(to, name, mother_pos));
+    }else{
+        throwIfFailed(write([&](){ return tree.tryAddMother(to, move(name)); }));
+    }
+    return *this;
+}
+
+ConcurrentTree& ConcurrentTree::addMother(string_view to, string_view name){
+    throwIfFailed(tryAddMother(to, name));
+    return *this;
+}
+
+ConcurrentTree& ConcurrentTree::addMother(string_view to, const char *name){
+    return addMother(to, string_view(name));
+}
+
+void ConcurrentTree::remove(string_view name){
+    throwIfFailed(tryRemove(name));
+}
+
+/*
+* tryAddFather / tryAddMother / tryRemove - the non throwing API of Tree, holding the lock exclusively
+* (except for the adds of the concurrent insertion).
+*/
+status ConcurrentTree::tryAddFather(string_view to, string_view name){
+    if(adding == insertion::concurrent){
+        return insert(to, name, father_pos);
+    }
+    return write([&](){ return tree.tryAddFather(to, name); });
+}
+
+status ConcurrentTree::tryAddMother(string_view to, string_view name){
+    if(adding == insertion::concurrent){
+        return insert(to, name, mother_pos);
+    }
+    return write([&](){ return tree.tryAddMother(to, name); });
+}
+
+status ConcurrentTree::tryRemove(string_view name){
+    return write([&](){ return tree.tryRemove(name); });
+}
+
+/*
+* compact - reclaims every removed person now (see Tree::compact), a slice at a time. The locks are released
+* between slices, so queries and changes go on meanwhile. For a background reclaimer, or a read mostly
+* workload after its removes.
+*/
+void ConcurrentTree::compact(){
+    for(bool done = false; !done;){
+        lock_guard<shared_mutex> serial(writing);
+        reclaim();
+        unique_lock<shared_mutex> exclusive(lock);
+        done = tree.compact(REMOVE_SLICE);
+        retire();
+    }
+}
+
+/*
+* display / relation / find / tryFind / relations / findAll - the queries of Tree, holding the lock shared.
+* In the epoch mode a linked tree finds people by relation without the lock (the lock is taken for the name only).
+*/
+void ConcurrentTree::display(ostream &out) const{
+    shared_lock<shared_mutex> reading(lock);
+    shared_lock<shared_mutex> names = readNames();
+    tree.display(out);
+}
+
+string ConcurrentTree::relation(string_view who) const{
+    shared_lock<shared_mutex> reading(lock);
+    shared_lock<shared_mutex> names = readNames();
+    return tree.relation(who);
+}
+
+size_t ConcurrentTree::relation(string_view who, char *buffer, size_t size) const{
+    shared_lock<shared_mutex> reading(lock);
+    shared_lock<shared_mutex> names = readNames();
+    return tree.relation(who, buffer, size);
+}
+
+string ConcurrentTree::find(string_view relation) const{
+    find_result result = tryFind(relation);
+    throwIfFailed(result.code);
+    return string(result.name);
+}
+
+find_result ConcurrentTree::tryFind(string_view relation) const{
+    if(tree.numbers != NULL || (mode == reclamation::immediate && adding == insertion::exclusive)){
+        shared_lock<shared_mutex> reading(lock);
+        return tree.tryFind(relation);
+    }
+    find_result result;
+    relation_data data = parseRelation(relation);
+    if(!data.valid){
+        result.code = status::bad_relation;
+        return result;
+    }
+    if(mode == reclamation::epoch){
+        EpochGuard inside(epochs);
+        node *found = walk(data);
+        shared_lock<shared_mutex> reading(lock); // The name pool grows under the exclusive lock.
+        return resultOf(found);
+    }
+    shared_lock<shared_mutex> reading(lock);
+    return resultOf(walk(data));
+}
+
+vector<string> ConcurrentTree::relations(span<const string_view> names) const{
+    shared_lock<shared_mutex> reading(lock);
+    shared_lock<shared_mutex> pool = readNames();
+    return tree.relations(names);
+}
+
+vector<find_result> ConcurrentTree::findAll(span<const string_view> relations) const{
+    shared_lock<shared_mutex> reading(lock);
+    shared_lock<shared_mutex> names = readNames();
+    return tree.findAll(relations);
+}
@@ -0,0 +1,113 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "FamilyTree.hpp"
+#include "Epoch.hpp"
+using namespace std;
+
+namespace family{
+    /*
+    * reclamation - the way a ConcurrentTree frees removed people.
+    * Both modes detach the branch in O(1) (see Tree::tryRemove) and leave it to the following changes, which reclaim
+    * a slice of it each, or to compact(). Lookups skip the removed people meanwhile.
+    * immediate - the reclaimed nodes go back to the arena right away, under the exclusive lock.
+    * epoch - the reclaimed nodes are retired, and returned to the arena by a later write once every reader which
+    *         could still see them is done. finding by relation walks the links without the lock.
+    */
+    enum class reclamation {
+        immediate, epoch
+    };
+
+    /*
+    * insertion - the way a ConcurrentTree adds fathers and mothers.
+    * exclusive - addFather/addMother hold the lock exclusively, like remove().
+    * concurrent - addFather/addMother run together on several threads: the parent is linked by a compare and swap on
+    *              the empty father/mother slot, and a failed swap is status::already_exist. Interning a new name and
+    *              indexing the parent, which write single hash tables, take the name lock exclusively for a moment, and
+    *              the node comes from the arena under a mutex of its own; the rest of an add runs in parallel.
+    *              Queries walk the links with acquire loads, so they run alongside the adds.
+    *              Trees of the ahnentafel engine always use the exclusive insertion (the numbering index is a set).
+    */
+    enum class insertion {
+        exclusive, concurrent
+    };
+
+    /*
+    * ConcurrentTree - a thread safe Tree for multi threaded query servers.
+    * Queries (relation, find, display ...) take a shared lock and run in parallel, while addFather/addMother/remove
+    * take the lock exclusively (see insertion for adds which don't). The tree owns a private name pool, since a pool shared with other trees would be
+    * written without this tree's lock.
+    * Names returned by tryFind/findAll point into the name pool, which never moves or drops a name, so they stay
+    * valid after the lock is released.
+    */
+    class ConcurrentTree{
+    private:
+        /*Private variables*/
+        mutable shared_mutex lock;
+        mutable shared_mutex writing;          // Writers hold it exclusively, concurrent adds shared.
+        mutable shared_mutex naming;           // The name pool and the name index, during concurrent adds.
+        mutex allocating;                      // The arena, during concurrent adds.
+        Tree tree;
+        reclamation mode;
+        insertion adding;
+        mutable EpochDomain epochs;
+        vector<node*> reclaimed;               // Nodes Tree::reclaim handed over in the epoch mode, not retired yet.
+        vector<pair<uint64_t, vector<node*>>> retired; // Reclaimed nodes and their retire epochs (guarded by 'writing').
+
+        /*Private methods*/
+        void reclaim();
+        void retire();
+        node* walk(relation_data data) const;
+        find_result resultOf(node *found) const;
+        status insert(string_view to, string_view name, position pos);
+        shared_lock<shared_mutex> readNames() const;
+
+        /* Runs a change of the tree holding the writer lock and the exclusive lock (freeing retired nodes first). */
+        template<typename Change>
+        status write(Change change){
+            lock_guard<shared_mutex> serial(writing);
+            reclaim();
+            unique_lock<shared_mutex> exclusive(lock);
+            status code = change();
+            retire();
+            return code;
+        }
+
+    public:
+        ConcurrentTree(string_view root, storage engine = storage::linked, reclamation mode = reclamation::immediate,
+                       insertion adding = insertion::exclusive);
+        ConcurrentTree(const ConcurrentTree&) = delete;
+        ConcurrentTree& operator=(const ConcurrentTree&) = delete;
+
+        ConcurrentTree& addFather(string_view to, string &&name);
+        ConcurrentTree& addFather(string_view to, string_view name);
+        ConcurrentTree& addFather(string_view to, const char *name);
+        ConcurrentTree& addMother(string_view to, string &&name);
+        ConcurrentTree& addMother(string_view to, string_view name);
+        ConcurrentTree& addMother(string_view to, const char *name);
+        void remove(string_view name);
+        void compact();
+
+        status tryAddFather(string_view to, string_view name);
+        status tryAddMother(string_view to, string_view name);
+        status tryRemove(string_view name);
+
+        void display(ostream &out) const;
+        string relation(string_view who) const;
+        size_t relation(string_view who, char *buffer, size_t size) const;
+        string find(string_view relation) const;
+        find_result tryFind(string_view relation) const;
+        vector<string> relations(span<const string_view> names) const;
+        vector<find_result> findAll(span<const string_view> relations) const;
+    };
+}
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <stdexcept>
+#include "FamilyTree.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* CsvRows - splits a mapped edge list into rows of "child,father,mother" (the father/mother fields may be empty).
+*/
+class CsvRows{
+private:
+    string_view rest;
+    size_t line = 0;
+
+    static string_view cut(string_view &text, char separator){
+        size_t at = text.find(separator);
+        string_view field = text.substr(0, at);
+        text.remove_prefix(at == string_view::npos ? text.size() : at + 1);
+        return field;
+    }
+
+public:
+    CsvRows(string_view text) : rest(text){
+    }
+
+    size_t lineNumber() const{
+        return line;
+    }
+
+    /* Reads the next non empty row, false at the end of the file. */
+    bool next(string_view fields[3], size_t &count){
+        while(!rest.empty()){
+            string_view row = cut(rest, '\n');
+            line++;
+            if(!row.empty() && row.back() == '\r'){
+                row.remove_suffix(1);
+            }
+            if(row.empty()){
+                continue;
+            }
+            count = 0;
+            while(count < 3){
+                fields[count++] = cut(row, ',');
+                if(row.empty()){
+                    break;
+                }
+            }
+            if(!row.empty()){
+                count = 4; // Too many fields.
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+/*
+* loadCsv - builds a tree from an edge list file in linear time.
+* Every row is "child,father,mother" (an optional first row "child,father,mother" is a header), a missing parent
+* is an empty field and a person may appear in several rows as long as they agree. Every name is a single person,
+* so a name can be the father/mother of one person only, and exactly one person (the root) is nobody's parent.
+* The file is mapped, names are resolved through the new tree's name pool, and the nodes are linked in one pass
+* from the root, without searching the tree.
+* param 1: path - the file path.
+* param 2: engine - the storage engine of the new tree.
+* return value: the tree. throws invalid_argument on a malformed file and system_error when it can't be read.
+*/
+unique_ptr<Tree> Tree::loadCsv(const string &path, storage engine){
+    MappedFile file(path);
+    string_view text = file.text();
+    size_t rows = count(text.begin(), text.end(), '\n') + 1;
+
+    shared_ptr<SymbolTable> symbols = make_shared<SymbolTable>();
+    symbols->reserve(2 * rows + 1);
+    vector<uint32_t> fathers, mothers; // Per symbol, NONE when unknown.
+    vector<bool> isParent;             // Per symbol.
+    fathers.reserve(2 * rows + 1);
+    mothers.reserve(2 * rows + 1);
+    isParent.reserve(2 * rows + 1);
+
+    CsvRows csv(text);
+    auto fail = [&](const string &message){
+        throw invalid_argument(path + ":" + to_string(csv.lineNumber()) + ": " + message);
+    };
+    auto failFile = [&](const string &message){
+        throw invalid_argument(path + ": " + message);
+    };
+    auto person = [&](string_view name){
+        uint32_t symbol = symbols->intern(name);
+        if(symbol == fathers.size()){
+            fathers.push_back(SymbolTable::NONE);
+            mothers.push_back(SymbolTable::NONE);
+            isParent.push_back(false);
+        }
+        return symbol;
+    };
+    auto link = [&](vector<uint32_t> &parents, uint32_t child, string_view name){
+        if(name.empty()){
+            return;
+        }
+        uint32_t parent = person(name);
+        if(parents[child] == parent){
+            return; // Repeated row.
+        }
+        if(parents[child] != SymbolTable::NONE){
+            fail(string(symbols->name(child)) + " already has a " + (&parents == &fathers ? "father" : "mother"));
+        }
+        if(isParent[parent]){
+            fail(string(name) + " is already the parent of someone else");
+        }
+        parents[child] = parent;
+        isParent[parent] = true;
+    };
+
+    string_view fields[3];
+    size_t fieldCount;
+    bool first = true;
+    while(csv.next(fields, fieldCount)){
+        if(fieldCount > 3){
+            fail("a row must be child,father,mother");
+        }
+        if(fields[0].empty()){
+            fail("missing child name");
+        }
+        if(first && fieldCount == 3 && fields[0] == "child" && fields[1] == "father" && fields[2] == "mother"){
+            first = false;
+            continue;
+        }
+        first = false;
+        uint32_t child = person(fields[0]);
+        link(fathers, child, fieldCount > 1 ? fields[1] : string_view());
+        link(mothers, child, fieldCount > 2 ? fields[2] : string_view());
+    }
+
+    uint32_t root = SymbolTable::NONE;
+    for(uint32_t symbol = 0; symbol < isParent.size(); symbol++){
+        if(!isParent[symbol]){
+            if(root != SymbolTable::NONE){
+                failFile("both " + string(symbols->name(root)) + " and " + string(symbols->name(symbol)) + " are nobody's parent");
+            }
+            root = symbol;
+        }
+    }
+    if(root == SymbolTable::NONE){
+        failFile("no root (the file is empty or every person is someone's parent)");
+    }
+
+    unique_ptr<Tree> T(new Tree(string(symbols->name(root)), engine, symbols));
+    size_t people = symbols->size();
+    T->nodes.reserve(people - 1);
+    T->index.reserve(people);
+    vector<node*> stack;
+    stack.push_back(T->root);
+    size_t linked = 1;
+    while(!stack.empty()){
+        node *son = stack.back();
+        stack.pop_back();
+        if(fathers[son->symbol] != SymbolTable::NONE){
+            stack.push_back(T->attach(son, fathers[son->symbol], father_pos));
+            linked++;
+        }
+        if(mothers[son->symbol] != SymbolTable::NONE){
+            stack.push_back(T->attach(son, mothers[son->symbol], mother_pos));
+            linked++;
+        }
+    }
+    if(linked != people){
+        failFile("some people are their own ancestors");
+    }
+    return T;
+}
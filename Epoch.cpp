@@ -0,0 +1,68 @@
+#include <functional>
+#include <thread>
+#include "Epoch.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* enter - announces the current epoch in a free reader slot.
+* The announcement is repeated until the epoch didn't move meanwhile, so a reader never announces an epoch
+* older than the one in which it starts reading.
+* return value: the slot, to be passed to exit().
+*/
+size_t EpochDomain::enter(){
+    size_t slot = hash<thread::id>()(this_thread::get_id()) % MAX_READERS;
+    uint64_t epoch = global.load();
+    for(uint64_t idle = IDLE; !readers[slot].epoch.compare_exchange_weak(idle, epoch); idle = IDLE){
+        slot = (slot + 1) % MAX_READERS;
+        if(slot == 0){
+            this_thread::yield(); // Every slot is taken.
+        }
+        epoch = global.load();
+    }
+    for(uint64_t current = global.load(); current != epoch; current = global.load()){
+        epoch = current;
+        readers[slot].epoch.store(epoch);
+    }
+    return slot;
+}
+
+/*
+* exit - ends the announcement of enter().
+*/
+void EpochDomain::exit(size_t slot){
+    readers[slot].epoch.store(IDLE);
+}
+
+/*
+* retire - starts a new epoch. must be called after the memory to retire was unlinked.
+* return value: the epoch of the retired memory, for safe().
+*/
+uint64_t EpochDomain::retire(){
+    return global.fetch_add(1);
+}
+
+/*
+* safe - checks whether every reader which started before some memory was retired is done.
+* param 1: retired - a value returned by retire().
+* return value: true when the memory may be freed.
+*/
+bool EpochDomain::safe(uint64_t retired) const{
+    for(const announcement &reader : readers){
+        if(reader.epoch.load() <= retired){
+            return false;
+        }
+    }
+    return true;
+}
+
+/*Outline constructor - enters the domain*/
+EpochGuard::EpochGuard(EpochDomain &domain) : domain(domain){
+    slot = domain.enter();
+}
+
+/*Outline destructor - leaves the domain*/
+EpochGuard::~EpochGuard(){
+    domain.exit(slot);
+}
@@ -0,0 +1,61 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+namespace family{
+    /*
+    * EpochDomain - the bookkeeping of epoch based reclamation.
+    * A reader announces the current epoch for as long as it may hold pointers into a shared structure (see EpochGuard).
+    * A writer which unlinks something calls retire() to get the epoch the unlinked memory belongs to,
+    * and may free it once safe() says that no reader which could have seen it is still running.
+    */
+    class EpochDomain{
+    public:
+        static const size_t MAX_READERS = 128;  // Readers inside the domain at the same time (more of them wait).
+        static const uint64_t IDLE = UINT64_MAX;
+
+    private:
+        struct alignas(64) announcement {
+            atomic<uint64_t> epoch{IDLE};
+        };
+
+        /*Private variables*/
+        atomic<uint64_t> global{1};
+        announcement readers[MAX_READERS];
+
+        /*Private methods*/
+        size_t enter();
+        void exit(size_t slot);
+        friend class EpochGuard;
+
+    public:
+        EpochDomain() = default;
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        uint64_t retire();
+        bool safe(uint64_t retired) const;
+    };
+
+    /*
+    * EpochGuard - a reader's stay inside an EpochDomain (memory retired meanwhile isn't freed before the guard ends).
+    */
+    class EpochGuard{
+    private:
+        EpochDomain &domain;
+        size_t slot;
+
+    public:
+        EpochGuard(EpochDomain &domain);
+        ~EpochGuard();
+        EpochGuard(const EpochGuard&) = delete;
+        EpochGuard& operator=(const EpochGuard&) = delete;
+    };
+}
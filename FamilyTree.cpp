@@ -1,17 +1,28 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
 #include <vector>
 #include "FamilyTree.hpp"
+#include "OutputBuffer.hpp"
+#include "Traversal.hpp"
+#include "WorkerPool.hpp"
 
 using namespace std;
 using namespace family;
 
+static const size_t PARALLEL_SEARCH_MIN = 1 << 16; // People searched by the caller alone before going parallel.
+static const size_t TASKS_PER_THREAD = 16;         // Subtrees per searching thread, to even out unbalanced trees.
+static const size_t CANCEL_CHECK = 1024;           // People visited between checks for cancellation.
+static const size_t RECLAIM_SLICE = 1024;          // Removed people taken out of the indexes per change of the tree.
+
 /*
 * Possible exceptions:
 * 1) deleteRootException - root can't be deleted.
 * 2) relationNotFoundException - relation doesn't exist.
 * 3) badRelationException - relation syntax is incorrect.
 * 4) alreadyExistException - when trying to add father/mother to someone who already exist.
-* 5) personNotFoundException - when trying to add father/mother to someone who doesn't exist.
+* 5) personNotFoundException - when trying to add father/mother to (or remove) someone who doesn't exist.
 */
 
 class deleteRootException: public exception
@@ -54,331 +65,572 @@ class personNotFoundException: public exception
     }
 } personNotFoundException;
 
-/*Outline constructor - creates new tree data structure with youngest person as root*/
-Tree::Tree(string root){
-    this->root = new node(root);
+/*
+* throwIfFailed - the bridge between the try* methods and the throwing API.
+* param 1: code - a status returned by one of the try* methods.
+*/
+void family::throwIfFailed(status code){
+    switch(code){
+        case status::ok: return;
+        case status::person_not_found: throw personNotFoundException;
+        case status::already_exist: throw alreadyExistException;
+        case status::relation_not_found: throw relationNotFoundException;
+        case status::bad_relation: throw badRelationException;
+        case status::delete_root: throw deleteRootException;
+    }
+}
+
+/*
+* Outline constructor - creates new tree data structure with youngest person as root.
+* param 1: root - the youngest person.
+* param 2: engine - the storage engine (linked by default).
+* param 3: symbols - a name pool to share with other trees (a private pool is created by default).
+*/
+Tree::Tree(string &&root, storage engine, shared_ptr<SymbolTable> symbols){
+    this->symbols = symbols != NULL ? move(symbols) : make_shared<SymbolTable>();
+    this->root = nodes.allocate(this->symbols->intern(move(root)));
+    addToIndex(this->root);
+    if(engine == storage::ahnentafel){
+        numbers = new AhnentafelIndex();
+        this->root->number = 1;
+        numbers->add(1, this->root);
+    }
+}
+
+Tree::Tree(string_view root, storage engine, shared_ptr<SymbolTable> symbols) : Tree(string(root), engine, move(symbols)){
+}
+
+Tree::Tree(const char *root, storage engine, shared_ptr<SymbolTable> symbols) : Tree(string(root), engine, move(symbols)){
 }
 
 /*Outline destructor - destruct the Tree*/
 Tree::~Tree(){
-    freeTree(this->root); // Free all dynamic memory that was allocated bt Tree nodes.
+    delete numbers; // Tree nodes themselves are released chunk by chunk by the node arena.
 }
 
 /*
-* freeTree - Free all dynamic memory that was allocated by tree nodes.
-* param root: The tree root.
+* symbolTable - the name pool of this tree, to be passed to the constructor of trees which should share it.
 */
-void Tree::freeTree(node *root)
-{
-    if(root != NULL)
-    {
-        freeTree(root->father);
-        freeTree(root->mother);
-        delete root;
-    }
+shared_ptr<SymbolTable> Tree::symbolTable() const{
+    return symbols;
 }
 
 /*
-* getChild - get child of a given person (by name).
-* param 1: who - the person who's child need to be found.
-* param 2: found - true/false flag to stop recursive function.
-* param 3: root = the root of the Tree.
-* return value: node* - if node found Or NULL in case of no child at all.
+* nameOf - the name of a person of this tree.
+* param 1: person - a node of this tree.
+* return value: a view which stays valid as long as the tree's name pool.
 */
-node* Tree::getChild(string who,bool found, node *root){
-    if(root != NULL){
-        if(found){
-            return root;
-        }else{
-            bool flag = false;
-            if(root->father != NULL) {
-               flag = root->father->name.compare(who) == 0;
-            }
-            node *found = flag ? getChild(who,flag,root) : getChild(who,flag,root->father);
-            if(found == NULL){
-                if(root->mother != NULL) {
-                    flag = root->mother->name.compare(who) == 0;
-                }
-                found = flag ? getChild(who,flag,root) : getChild(who,flag,root->mother);
+string_view Tree::nameOf(const node *person) const{
+    return symbols->name(person->symbol);
+}
+
+/*
+* reclaim - takes removed people out of the indexes and returns them to the node arena, a bounded slice at a time.
+* The parents of a reclaimed person become the roots of their own removed branches (their child is cleared),
+* so alive() never follows a link into a released node. When 'retiring' is set the nodes are handed over
+* instead of released, for an owner whose readers may still be walking them (see ConcurrentTree).
+* param 1: limit - the most people reclaimed by this call.
+*/
+void Tree::reclaim(size_t limit){
+    for(size_t i = 0; i < limit && !graveyard.empty(); i++){
+        node *person = graveyard.back();
+        graveyard.pop_back();
+        for(node *parent : {person->father, person->mother}){
+            if(parent != NULL){
+                parent->child = NULL;
+                graveyard.push_back(parent);
             }
-            return found;
         }
-    }else{
-        return NULL;
+        removeFromIndex(person);
+        // The number may already belong to a person added in the same place since.
+        if(person->number != 0 && numbers->at(person->number) == person){
+            numbers->remove(person->number);
+        }
+        if(retiring != NULL){
+            retiring->push_back(person);
+        }else{
+            nodes.release(person);
+        }
+    }
+    if(graveyard.empty()){
+        shallowest = INT_MAX;
+    }
+}
+
+/*
+* alive - checks that a person the indexes hold wasn't removed (see tryRemove).
+* A removed branch keeps its links, but its root has no child, so the walk down the children of a removed person
+* ends at someone other than the root. Only children deeper than the shallowest removed person are visited.
+* param 1: person - a person from the name index or the numbering index.
+*/
+bool Tree::alive(const node *person) const{
+    if(graveyard.empty()){
+        return true;
+    }
+    while(person->child != NULL && person->depth > shallowest){
+        person = person->child;
+    }
+    return person->child != NULL || person == root;
+}
+
+/*
+* before - checks whether a person comes before another one in preorder (a person, then his father's side,
+* then his mother's side), by walking both down their children to where their lines meet. O(depth).
+* param 1: a, b - two different people of the same tree.
+*/
+static bool before(const node *a, const node *b){
+    while(a->depth > b->depth){
+        a = a->child;
+    }
+    while(b->depth > a->depth){
+        b = b->child;
+    }
+    if(a == b){
+        return false; // a was an ancestor of b, which comes first.
+    }
+    while(a->child != b->child){
+        a = a->child;
+        b = b->child;
+    }
+    return a->pos == father_pos;
+}
+
+/*
+* addToIndex - registers a person in the name index.
+* param 1: person - a node which was just added to the tree.
+*/
+void Tree::addToIndex(node *person){
+    named_people &entry = index[person->symbol];
+    person->named = entry.people.size();
+    entry.people.push_back(person);
+    if(entry.first == NULL){
+        entry.first = person;
+    }else if(!alive(entry.first)){
+        entry.first = firstAlive(entry.people); // The first one was removed and isn't reclaimed yet.
+    }else if(before(person, entry.first)){
+        entry.first = person;
     }
 }
 
 /*
-* search - get person's node by given name.
+* removeFromIndex - unregisters a person from the name index, in O(1) unless he was the first of his name.
+* param 1: person - a node which is about to be removed from the tree.
+*/
+void Tree::removeFromIndex(node *person){
+    auto entry = index.find(person->symbol);
+    if(entry != index.end()){
+        vector<node*> &people = entry->second.people;
+        people[person->named] = people.back();
+        people[person->named]->named = person->named;
+        people.pop_back();
+        if(people.empty()){
+            index.erase(entry);
+        }else if(entry->second.first == person){
+            entry->second.first = firstAlive(people);
+        }
+    }
+}
+
+/*
+* search - get person's node by given name using the name index.
+* When the same name appears more than once in the tree the first one in preorder is returned.
 * param 1: who - the person who need to be found.
-* param 2: root = the root of the Tree.
 * return value: node* - if node found Or NULL in case of no matching.
 */
-node* Tree::search(string who,node *root){
-    if(root != NULL){
-        if(root->name.compare(who) == 0){
-            return root;
-        }else{
-            node *found = search(who,root->father);
-            if(found == NULL){
-                found = search(who,root->mother);
-            }
-            return found;
-        }
-    }else{
+node* Tree::search(string_view who) const{
+    uint32_t symbol = symbols->find(who);
+    if(symbol == SymbolTable::NONE){
         return NULL;
     }
+    return firstNamed(symbol);
 }
 
 /*
-* search - search person by given name and get relation information object in return (relation_data).
-* param 1: who - the person who need to be found.
-* param 2: currentDepth = the current depth (recuresive iteration).
-* param 3: pos = self/father/mother.
-* param 4: root = Tree root.
-* return value: relation_data - an object which contains relation information: depth, sex and validation flag.
+* firstNamed - the first person in preorder of a name who wasn't removed.
+* param 1: symbol - the name's symbol.
+* return value: node* - the person Or NULL.
 */
-relation_data Tree::search(string who,int currentDepth, position pos, node *root){
-    relation_data data;
-    if(root != NULL){
-        if(root->name.compare(who) == 0){
-            data.valid = true;
-            data.depth = currentDepth;
-            data.pos = pos;
-            return data;
-        }else{
-            relation_data found = search(who ,++currentDepth , father_pos, root->father);
-            if(!found.valid){
-                found = search(who ,currentDepth , mother_pos, root->mother);
-            }
-            return found;
+node* Tree::firstNamed(uint32_t symbol) const{
+    auto entry = index.find(symbol);
+    if(entry == index.end()){
+        return NULL;
+    }
+    node *first = entry->second.first;
+    if(first == NULL || alive(first)){
+        return first;
+    }
+    return firstAlive(entry->second.people); // The first one was removed and isn't reclaimed yet.
+}
+
+/*
+* firstAlive - the first person in preorder among people of a name, skipping removed people. O(people * depth).
+* param 1: people - the people of a name index entry.
+* return value: node* - the person Or NULL when all of them were removed.
+*/
+node* Tree::firstAlive(const vector<node*> &people) const{
+    node *first = NULL;
+    for(node *person : people){
+        if(alive(person) && (first == NULL || before(person, first))){
+            first = person;
         }
-    }else{
-        data.valid = false;
-        return data;
     }
+    return first;
 }
 
 /*
-* search - search person by relation_data object.
+* firstNumbered - the first person in preorder of a generation and side, from the numbering index.
+* When the indexed person was removed and not reclaimed yet, the tree is searched instead.
+* param 1: data - relation data object (depth must not exceed AhnentafelIndex::MAX_DEPTH).
+* return value: node* - the person Or NULL.
+*/
+node* Tree::firstNumbered(relation_data data) const{
+    node *person = numbers->first(data);
+    return person == NULL || alive(person) ? person : search(data);
+}
+
+/*
+* search - search person by relation_data object (depth limited preorder search).
 * param 1: data - relation data object.
-* param 2: currentDepth = the current depth (recuresive iteration).
-* param 3: pos = self/father/mother.
-* param 4: root = Tree root.
-* return value: node* - if person was found by the specified data object. NULL in case of no match.
-*/
-node* Tree::search(relation_data data ,int currentDepth, position pos ,node *root){
-    if(root != NULL && currentDepth <= data.depth){
-        if(data.depth == currentDepth && data.pos == pos){
-            return root;
-        }else{
-            node *found = search(data,++currentDepth,father_pos,root->father);
-            if(found == NULL){
-                found = search(data,currentDepth,mother_pos,root->mother);
-            }
-            return found;
-        }
-    }else{
-        return NULL;
+* return value: node* - the first person in preorder matching the specified data object. NULL in case of no match.
+*/
+node* Tree::search(relation_data data) const{
+    return preorder(this->root, data.depth, [&data](node *person){
+        return person->depth == data.depth && person->pos == data.pos;
+    });
+}
+
+/*
+* attach - creates a new person and links him as the father/mother of an existing person.
+* param 1: son - the existing person (his father/mother slot must be empty).
+* param 2: symbol - the new person's interned name.
+* param 3: pos - father_pos or mother_pos.
+* return value: node* - the new person.
+*/
+node* Tree::attach(node *son, uint32_t symbol, position pos){
+    node *parent = nodes.allocate(symbol);
+    parent->depth = son->depth + 1;
+    parent->pos = pos;
+    parent->number = 0;
+    parent->child = son;
+    if(numbers != NULL && son->number != 0 && parent->depth <= AhnentafelIndex::MAX_DEPTH){
+        parent->number = pos == father_pos ? AhnentafelIndex::fatherOf(son->number) : AhnentafelIndex::motherOf(son->number);
+        numbers->add(parent->number, parent);
     }
+    // Published last, with a release store, so readers which walk the links without a lock see a complete node.
+    atomic_ref<node*>(pos == father_pos ? son->father : son->mother).store(parent, memory_order_release);
+    addToIndex(parent);
+    return parent;
 }
 
 /*
-* split - splits a string by given delimiter.
-* param 1: s - string input to split.
-* param 2: delimiter - specified character.
-* return value: vector of string splited by the specified delimiter.
+* vacancy - checks that a father/mother can be added to a person (and reclaims a slice of removed people first).
+* param 1: to - someone to add father/mother to.
+* param 2: pos - father_pos or mother_pos.
+* param 3: son - set to the person's node when he is found.
+* return value: status::ok, status::person_not_found or status::already_exist.
 */
-vector<string> Tree::split(const string& s, char delimiter){
-    vector<string> words;
-    string word = "";
-    istringstream stream(s);
-    while(getline(stream,word,delimiter)){
-        words.push_back(word);
+status Tree::vacancy(string_view to, position pos, node *&son){
+    reclaim(RECLAIM_SLICE);
+    son = search(to);
+    if(son == NULL){
+        return status::person_not_found;
     }
-    return words;
+    node *parent = pos == father_pos ? son->father : son->mother;
+    return parent == NULL ? status::ok : status::already_exist;
 }
 
 /*
-* getRelationData - creates relation_data object by splitted string of relation (Example: "great-great-grandfather").
-* param 1: relation - a vector of splitted words which represents realtion.
-* return value: data - relation_data object.
+* tryAddFather - adds father to child who already exist, without throwing.
+* param 1: to - someone to add father to.
+* param 2: name - the father's name, moved into the tree (only on success).
+* return value: status::ok, status::person_not_found or status::already_exist.
 */
-relation_data Tree::getRelationData(vector<string> relation){
-    relation_data data;
-    int size = relation.size();
-    set<string> valid_words = {"me", "father", "mother", "grandfather", "grandmother", "great"};
-    if(size < 1)
-        data.valid = false;
-    if(size == 1){
-        string word = relation.at(0);
-        if(valid_words.find(word) != valid_words.end()){
-            if(word.compare("me") == 0) {
-                data.valid = true;
-                data.pos = self;
-                data.depth = 0;
-            }else if(word.compare("mother") == 0){
-                data.valid = true;
-                data.pos = mother_pos;
-                data.depth = 1;
-            } else if (word.compare("father") == 0){
-                data.valid = true;
-                data.pos = father_pos;
-                data.depth = 1;
-            } else if (word.compare("grandfather") == 0){
-                data.valid = true;
-                data.pos = father_pos;
-                data.depth = 2;
-            }else if (word.compare("grandmother") == 0){
-                data.valid = true;
-                data.pos = mother_pos;
-                data.depth = 2;
-            }else{
-                data.valid = false;
-            }
-        }else{
-            data.valid = false;
-        }
-    } else{
-       //more than one word
-       data.valid = true;
-       unsigned int counter = 0;
-        string lastMember = relation.at(size-1);
-        for(string s : relation){
-            if(valid_words.find(s) == valid_words.end() || ((s.compare("great") != 0)&&(counter < size-1)) ||
-                    ((lastMember.compare("grandfather") != 0) && (lastMember.compare("grandmother") != 0))){
-                data.valid = false;
-                break;
-            } else{
-                counter++;
-            }
-        }
-        if(data.valid){
-            data.valid = true;
-            data.depth = counter + 1;
-            data.pos = lastMember.compare("grandfather") == 0 ? father_pos : mother_pos;
-        }
+status Tree::tryAddFather(string_view to, string &&name){
+    node *son;
+    status code = vacancy(to, father_pos, son);
+    if(code == status::ok){
+        attach(son, symbols->intern(move(name)), father_pos);
     }
-    return data;
+    return code;
+}
+
+/* Borrowed names are copied only on success, and only when the name pool doesn't hold them yet. */
+status Tree::tryAddFather(string_view to, string_view name){
+    node *son;
+    status code = vacancy(to, father_pos, son);
+    if(code == status::ok){
+        attach(son, symbols->intern(name), father_pos);
+    }
+    return code;
+}
+
+status Tree::tryAddFather(string_view to, const char *name){
+    return tryAddFather(to, string_view(name));
 }
 
 /*
-* relationDataToString - the inverse function of 'getRelationData'. the function constructs a string from realtion_data object.
-* param 1: data - relation_data object.
-* return value: a string which describes a relation (Example: "great-great-grandmother").
+* tryAddMother - adds mother to child who already exist, without throwing.
+* param 1: to - someone to add mother to.
+* param 2: name - the mother's name, moved into the tree (only on success).
+* return value: status::ok, status::person_not_found or status::already_exist.
 */
-string Tree::relationDataToString(relation_data data){
-    string to_return = "";
-    if(data.valid){
-        if(data.depth == 0){
-            to_return = "me";
-        } else if (data.depth == 1){
-            if(data.pos == father_pos){
-                to_return = "father";
-            }else{
-                to_return = "mother";
-            }
-        }else if (data.depth == 2){
-            if(data.pos == father_pos){
-                to_return = "grandfather";
-            }else{
-                to_return = "grandmother";
-            }
-        }else{
-            for(int i = 0; i < data.depth-2; i++){
-                to_return += "great-";
-            }
-            if(data.pos == father_pos){
-                to_return += "grandfather";
-            }else{
-                to_return += "grandmother";
-            }
-        }
+status Tree::tryAddMother(string_view to, string &&name){
+    node *son;
+    status code = vacancy(to, mother_pos, son);
+    if(code == status::ok){
+        attach(son, symbols->intern(move(name)), mother_pos);
     }
-    return to_return;
+    return code;
+}
+
+/* Borrowed names are copied only on success, and only when the name pool doesn't hold them yet. */
+status Tree::tryAddMother(string_view to, string_view name){
+    node *son;
+    status code = vacancy(to, mother_pos, son);
+    if(code == status::ok){
+        attach(son, symbols->intern(name), mother_pos);
+    }
+    return code;
+}
+
+status Tree::tryAddMother(string_view to, const char *name){
+    return tryAddMother(to, string_view(name));
 }
 
 /*
 * addFather - a function which adds father to child who already exist.
 * param 1: to - someone to add father to.
+* param 2: name - the father's name, moved into the tree.
 * return value: a reference to the Tree object.
 */
-Tree& Tree::addFather(string to, string name){
-    node *son = search(to,this->root);
-    if(son == NULL){
-        throw personNotFoundException;
-    }else{
-        if(son->father == NULL){
-            node *f = new node(name);
-            son->father = f;
-        }else{
-            throw alreadyExistException;
-        }
-    }
+Tree& Tree::addFather(string_view to, string &&name){
+    throwIfFailed(tryAddFather(to, move(name)));
+    return *this;
+}
+
+Tree& Tree::addFather(string_view to, string_view name){
+    throwIfFailed(tryAddFather(to, name));
     return *this;
 }
 
+Tree& Tree::addFather(string_view to, const char *name){
+    return addFather(to, string_view(name));
+}
+
 /*
 * addMother - a function which adds mother to child who already exist.
 * param 1: to - someone to add mother to.
+* param 2: name - the mother's name, moved into the tree.
 * return value: a reference to the Tree object.
 */
-Tree& Tree::addMother(string to, string name){
-    node *son = search(to,this->root);
-    if(son == NULL){
-        throw personNotFoundException;
-    }else{
-        if(son->mother == NULL){
-            node *m = new node(name);
-            son->mother = m;
-        }else{
-            throw alreadyExistException;
-        }
-    }
+Tree& Tree::addMother(string_view to, string &&name){
+    throwIfFailed(tryAddMother(to, move(name)));
+    return *this;
+}
+
+Tree& Tree::addMother(string_view to, string_view name){
+    throwIfFailed(tryAddMother(to, name));
     return *this;
 }
 
+Tree& Tree::addMother(string_view to, const char *name){
+    return addMother(to, string_view(name));
+}
+
+/*
+* display - prints the tree in preorder and writes relevant relation info.
+*/
+void Tree::display(){
+    display(cout);
+    cout.flush();
+}
+
 /*
-* Helper function of display().
-* printPreOrder - prints Tree preorder and writes relevant relation info.
-* param 1: child - a child node of given father/mother node.
-* param 2: next - given father/mother.
-* param 3: pos - is father or mother.
+* display - writes the tree in preorder with relevant relation info, one line per person.
+* The text is buffered and the stream isn't flushed.
+* param 1: out - the output stream.
 */
-void printPreOrder(node *child, node *next, position pos){
-    if(next == NULL)
-        return;
-        string relationType = pos == father_pos ? "father" : "mother";
-        if(child == NULL){
-            cout << next->name << endl;
+void Tree::display(ostream &out) const{
+    OutputBuffer text(out);
+    preorder(this->root, [this, &text](node *person){
+        if(person->child == NULL){
+            text << nameOf(person) << '\n';
         }else {
-            cout << child->name+"'s "+relationType + ": " + next->name << endl;
+            const char *relationType = person->pos == father_pos ? "father" : "mother";
+            text << nameOf(person->child) << "'s " << relationType << ": " << nameOf(person) << '\n';
         }
-        printPreOrder(next,next->father,father_pos);
-        printPreOrder(next,next->mother,mother_pos);
+        return false;
+    });
 }
 
 /*
-* display - prints the tree.
+* relationOf - get relation information of a person from the depth and position cached in the person's node.
+* param 1: who - a name of person.
+* return value: relation_data - data.valid is false when the person is not in the tree.
 */
-void Tree::display(){
-    printPreOrder(NULL,this->root,father_pos);
+relation_data Tree::relationOf(string_view who) const{
+    node *found = search(who);
+    relation_data data;
+    data.valid = found != NULL;
+    data.depth = data.valid ? found->depth : 0;
+    data.pos = data.valid ? found->pos : self;
+    return data;
 }
 
 /*
 * relation - get relation information (father/mother...granfather..).
 * param 1: who - a name of person.
-* return value: string which represents a relation (Example: "me" or "father" ..).
+* return value: string which represents a relation (Example: "me" or "father" ..) Or "unrelated".
 */
-string Tree::relation(string who){
-    relation_data data = search(who,0,father_pos,this->root);
-    string to_return = "";
-    if(data.valid) {
-        to_return = relationDataToString(data);
-    }else{
-        to_return = "unrelated";
+string Tree::relation(string_view who) const{
+    return relationToString(relationOf(who));
+}
+
+/*
+* relation - writes relation information into a caller provided buffer without allocating.
+* param 1: who - a name of person.
+* param 2: buffer - the destination buffer.
+* param 3: size - the size of the destination buffer.
+* return value: the length of the relation string, see writeRelation().
+*/
+size_t Tree::relation(string_view who, char *buffer, size_t size) const{
+    return writeRelation(relationOf(who), buffer, size);
+}
+
+/*
+* advance - continues a preorder search for a relation, for at most 'limit' people.
+* param 1: stack - the people still to visit, the next one on top (their subtrees follow in preorder).
+* param 2: data - relation data object.
+* param 3: limit - the most people visited.
+* return value: the first person matching the relation Or NULL (the stack is empty when the search is over).
+*/
+static node* advance(NodeStack &stack, relation_data data, size_t limit){
+    for(size_t visited = 0; visited < limit && !stack.empty(); visited++){
+        node *current = stack.pop();
+        if(current->depth == data.depth && current->pos == data.pos){
+            return current;
+        }
+        if(current->depth < data.depth){
+            node *mother = loadLink(current->mother);
+            node *father = loadLink(current->father);
+            if(mother != NULL){
+                stack.push(mother);
+            }
+            if(father != NULL){
+                stack.push(father);
+            }
+        }
     }
-    return to_return;
+    return NULL;
+}
+
+/*
+* search - a parallel search for a relation, for large trees of the linked engine.
+* The caller first searches the first PARALLEL_SEARCH_MIN people alone, so small trees (counting only the people
+* still in the tree) and matches early in preorder never go parallel. Otherwise the subtrees that pre-pass left
+* unvisited are split, a generation at a time, until there are TASKS_PER_THREAD of them per thread, and the threads
+* of the shared WorkerPool take them in preorder. A thread which finds a match cancels the subtrees after its own,
+* so the result is the same person the sequential search finds, and nobody is visited twice.
+* param 1: data - relation data object.
+* param 2: threads - the number of threads (0 for every hardware thread).
+* return value: the first person in preorder matching the relation Or NULL.
+*/
+node* Tree::search(relation_data data, size_t threads) const{
+    if(threads == 1){
+        return search(data);
+    }
+    NodeStack stack;
+    stack.push(root);
+    node *match = advance(stack, data, PARALLEL_SEARCH_MIN);
+    if(match != NULL || stack.empty()){
+        return match;
+    }
+    static const size_t hardwareThreads = max(1u, thread::hardware_concurrency()); // Asking reads /sys every time.
+    if(threads == 0){
+        threads = hardwareThreads;
+    }
+    if(threads == 1){
+        return advance(stack, data, SIZE_MAX);
+    }
+    vector<node*> subtrees; // The unvisited subtrees, in preorder.
+    while(!stack.empty()){
+        subtrees.push_back(stack.pop());
+    }
+    while(subtrees.size() < threads * TASKS_PER_THREAD){
+        vector<node*> split;
+        split.reserve(subtrees.size() * 2);
+        bool grew = false;
+        for(node *person : subtrees){
+            if(person->depth < data.depth){ // Not a match himself, so his parents' subtrees replace his.
+                grew = true;
+                node *father = loadLink(person->father);
+                node *mother = loadLink(person->mother);
+                if(father != NULL){
+                    split.push_back(father);
+                }
+                if(mother != NULL){
+                    split.push_back(mother);
+                }
+            }else{
+                split.push_back(person);
+            }
+        }
+        subtrees.swap(split);
+        if(!grew){
+            break;
+        }
+    }
+
+    atomic<size_t> next(0);
+    atomic<size_t> best(subtrees.size()); // The first subtree with a match so far.
+    vector<node*> found(subtrees.size(), NULL);
+    auto work = [&](){
+        for(size_t task = next++; task < best.load(memory_order_relaxed); task = next++){
+            size_t visited = 0;
+            node *match = preorder(subtrees[task], data.depth, [&](node *person){
+                if(++visited % CANCEL_CHECK == 0 && best.load(memory_order_relaxed) < task){
+                    return true;
+                }
+                return person->depth == data.depth && person->pos == data.pos;
+            });
+            if(match != NULL && match->depth == data.depth && match->pos == data.pos){
+                found[task] = match;
+                size_t first = best.load(memory_order_relaxed);
+                while(task < first && !best.compare_exchange_weak(first, task, memory_order_relaxed)){
+                }
+            }
+        }
+    };
+    WorkerPool::shared().run(threads - 1, work);
+    return best < subtrees.size() ? found[best] : NULL;
+}
+
+/*
+* tryFind - search person's name by given relation type, without throwing.
+* param 1: relation - a relation type (Example: "grandfather").
+* param 2: threads - the number of threads searching a large tree of the linked engine (0 for every hardware thread).
+* return value: find_result - the name on success, otherwise status::bad_relation or status::relation_not_found.
+*/
+find_result Tree::tryFind(string_view relation, size_t threads) const{
+    find_result result;
+    result.code = status::ok;
+    relation_data data = parseRelation(relation);
+    if(data.valid){
+        node *found;
+        if(numbers != NULL && data.depth <= AhnentafelIndex::MAX_DEPTH){
+            found = firstNumbered(data);
+        }else{
+            found = search(data, threads);
+        }
+        if(found != NULL){
+            result.name = nameOf(found);
+        }else{
+            result.code = status::relation_not_found;
+        }
+    } else{
+        result.code = status::bad_relation;
+    }
+    return result;
 }
 
 /*
@@ -386,42 +638,160 @@ string Tree::relation(string who){
 * param 1: relation - a relation type (Example: "grandfather").
 * return value: string (name).
 */
-string Tree::find(string relation){
-    string to_return = "";
-    vector<string> relationVector = split(relation,'-');
-    if(relationVector.empty()){
-        throw badRelationException;
+string Tree::find(string_view relation) const{
+    find_result result = tryFind(relation);
+    throwIfFailed(result.code);
+    return string(result.name);
+}
+
+/*
+* relations - the relation of every name of a batch (see relation()), each one a single name index lookup.
+* param 1: names - names of people.
+* return value: the relations, in the order of the names.
+*/
+vector<string> Tree::relations(span<const string_view> names) const{
+    vector<string> result;
+    result.reserve(names.size());
+    for(string_view who : names){
+        result.push_back(relationToString(relationOf(who)));
+    }
+    return result;
+}
+
+/*
+* findAll - the person of every relation of a batch (see tryFind).
+* The ahnentafel engine answers every relation from its index, the linked engine answers the whole batch
+* with a single preorder search which only descends while some relation deeper than the current person is still missing.
+* param 1: relations - relation types (Example: "grandfather").
+* return value: a find_result for every relation, in the order of the relations.
+*/
+vector<find_result> Tree::findAll(span<const string_view> relations) const{
+    vector<find_result> result(relations.size());
+    vector<relation_data> wanted(relations.size());
+    int maxDepth = -1;
+    for(size_t i = 0; i < relations.size(); i++){
+        wanted[i] = parseRelation(relations[i]);
+        result[i].code = wanted[i].valid ? status::relation_not_found : status::bad_relation;
+        if(wanted[i].valid){
+            maxDepth = max(maxDepth, wanted[i].depth);
+        }
+    }
+    if(maxDepth < 0){
+        return result;
+    }
+
+    // People found by key (depth*2, plus one on the mother's side), NULL until found.
+    auto keyOf = [](int depth, position pos){
+        return (size_t)depth * 2 + (pos == mother_pos ? 1 : 0);
+    };
+    vector<node*> found(keyOf(maxDepth, mother_pos) + 1, NULL);
+    vector<bool> asked(found.size(), false);
+    vector<int> missing(maxDepth + 1, 0); // Relations not found yet, by depth.
+    for(const relation_data &data : wanted){
+        if(data.valid && !asked[keyOf(data.depth, data.pos)]){
+            asked[keyOf(data.depth, data.pos)] = true;
+            missing[data.depth]++;
+        }
+    }
+    if(numbers != NULL && maxDepth <= AhnentafelIndex::MAX_DEPTH){
+        for(const relation_data &data : wanted){
+            if(data.valid){
+                found[keyOf(data.depth, data.pos)] = firstNumbered(data);
+            }
+        }
     }else{
-        relation_data data = getRelationData(relationVector);
-        if(data.valid){
-            node *found = Tree::search(data,0,self,this->root);
-            if(found != NULL){
-                to_return = found->name;
-            }else{
-                throw relationNotFoundException;
+        int deepest = maxDepth; // The deepest depth with a missing relation.
+        NodeStack stack;
+        stack.push(this->root);
+        while(!stack.empty() && deepest >= 0){
+            node *person = stack.pop();
+            size_t key = keyOf(person->depth, person->pos);
+            if(person->depth <= deepest && asked[key] && found[key] == NULL){
+                found[key] = person;
+                missing[person->depth]--;
+                while(deepest >= 0 && missing[deepest] == 0){
+                    deepest--;
+                }
+            }
+            if(person->depth < deepest){
+                node *mother = loadLink(person->mother);
+                node *father = loadLink(person->father);
+                if(mother != NULL){
+                    stack.push(mother);
+                }
+                if(father != NULL){
+                    stack.push(father);
+                }
             }
-        } else{
-            throw badRelationException;
         }
     }
-    return to_return;
+
+    for(size_t i = 0; i < relations.size(); i++){
+        node *person = wanted[i].valid ? found[keyOf(wanted[i].depth, wanted[i].pos)] : NULL;
+        if(person != NULL){
+            result[i].code = status::ok;
+            result[i].name = nameOf(person);
+        }
+    }
+    return result;
 }
 
 /*
-* remove - removes a person and all lower depth relations (of the specified person).
+* unlink - detaches a person (and his ancestors) from his child. the branch stays in the indexes and in the arena.
 * param 1: name - person's name.
+* param 2: person - set to the detached person on success.
+* return value: status::ok, status::person_not_found or status::delete_root.
 */
-void Tree::remove(string name){
-    node *child = getChild(name, false, this->root);
-    bool deleteFather = false;
-    if(child != NULL) {
-        if(child->father != NULL) {
-            if (child->father->name.compare(name) == 0)
-                deleteFather = true;
-        }
-        freeTree(this->search(name, this->root));
-        deleteFather ? child->father = NULL : child->mother = NULL;
-    } else{
-        throw deleteRootException;
+status Tree::unlink(string_view name, node *&person){
+    person = search(name);
+    if(person == NULL){
+        return status::person_not_found;
     }
+    node *child = person->child;
+    if(child == NULL){
+        return status::delete_root;
+    }
+    atomic_ref<node*>(child->father == person ? child->father : child->mother).store(NULL, memory_order_release);
+    return status::ok;
+}
+
+/*
+* tryRemove - removes a person and all lower depth relations (of the specified person), without throwing.
+* The branch is detached in O(1) whatever its size, and left to the following adds and removes,
+* which take RECLAIM_SLICE removed people each out of the indexes (lookups skip them meanwhile).
+* Until the branch is reclaimed, a name or numbering lookup which lands on an indexed person walks his children down
+* to the depth of the shallowest removed person to see that he is alive, so a tree which only answers queries after
+* a remove should call compact() once its removes are done.
+* param 1: name - person's name.
+* return value: status::ok, status::person_not_found or status::delete_root.
+*/
+status Tree::tryRemove(string_view name){
+    reclaim(RECLAIM_SLICE);
+    node *person;
+    status code = unlink(name, person);
+    if(code == status::ok){
+        person->child = NULL; // Marks the branch removed, see alive().
+        shallowest = min(shallowest, person->depth);
+        graveyard.push_back(person);
+    }
+    return code;
+}
+
+/*
+* remove - removes a person and all lower depth relations (of the specified person).
+* param 1: name - person's name.
+*/
+void Tree::remove(string_view name){
+    throwIfFailed(tryRemove(name));
+}
+
+/*
+* compact - reclaims removed people now instead of in the slices of the following changes (see tryRemove),
+* so lookups stop checking whether the people they find were removed.
+* param 1: limit - the most people reclaimed by this call (all of them by default).
+* return value: true when no removed person is left to reclaim.
+*/
+bool Tree::compact(size_t limit){
+    reclaim(limit);
+    return graveyard.empty();
 }
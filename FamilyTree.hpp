@@ -4,61 +4,156 @@
 
 #pragma once
 
+#include <climits>
+#include <cstdint>
 #include <iostream>
 #include <vector>
-#include <set>
-#include <sstream>
 #include <map>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <string_view>
+#include "Relation.hpp"
+#include "SymbolTable.hpp"
+#include "NodeArena.hpp"
+#include "Ahnentafel.hpp"
 using namespace std;
 
-enum position {
-    self, father_pos, mother_pos
-};
-
-struct relation_data {
-    bool valid;
-    int depth;
-    position pos;
-};
-
 struct node
 {
-    string name;
+    uint32_t symbol; // The person's name, interned in the tree's SymbolTable.
+    uint32_t named;  // The person's place among the people of his name in the name index.
     node *father;
     node *mother;
+    node *child;   // The person this node is the father/mother of (NULL for the root).
+    int depth;     // Generations above the root (0 for the root itself).
+    position pos;  // Whether this person is the father or the mother of its child.
+    uint64_t number; // Ahnentafel number (root = 1), 0 when the tree doesn't number its people.
 
-    node(string name){
-        this->name = name;
-        father = mother = NULL;
+    node(uint32_t symbol){
+        this->symbol = symbol;
+        named = 0;
+        father = mother = child = NULL;
+        depth = 0;
+        pos = self;
+        number = 0;
     }
 };
 
 namespace family{
+    /*
+    * storage - the way a Tree finds people by relation.
+    * linked - depth limited search over the father/mother links.
+    * ahnentafel - every person is also numbered Ahnentafel style (see AhnentafelIndex), so finding
+    *              a generation and side is a lookup instead of a search.
+    */
+    enum class storage {
+        linked, ahnentafel
+    };
+
+    /*
+    * status - the outcome of the non throwing try* methods. Every failure matches one of the exceptions of the throwing API.
+    */
+    enum class status {
+        ok, person_not_found, already_exist, relation_not_found, bad_relation, delete_root
+    };
+
+    /*
+    * named_people - an entry of the name index: the people of one name (in no particular order, a person's place
+    * is node::named, so leaving the entry is O(1)) and the first of them in preorder, which a lookup of the name finds.
+    */
+    struct named_people {
+        node *first = NULL;
+        vector<node*> people;
+    };
+
+    /*
+    * find_result - the outcome of Tree::tryFind. name points into the tree's name pool and stays valid as long as the pool.
+    */
+    struct find_result {
+        status code;
+        string_view name;
+
+        explicit operator bool() const {
+            return code == status::ok;
+        }
+    };
+
+    void throwIfFailed(status code);
+
+    class CompactTree;
+
     class Tree{
     private:
+        friend class CompactTree;
+        friend class ConcurrentTree;
+
         /*Private variables*/
         node *root = NULL;
+        NodeArena nodes; // Owns the memory of every node in the tree.
+        shared_ptr<SymbolTable> symbols; // The names of the people, possibly shared with other trees.
+        unordered_map<uint32_t, named_people> index; // Symbol -> people with that name.
+        AhnentafelIndex *numbers = NULL; // Only allocated by the ahnentafel storage engine.
+        vector<node*> graveyard; // Removed people still in the indexes, taken out a slice per change (see reclaim).
+        int shallowest = INT_MAX; // No removed person in the graveyard is shallower than this depth.
+        vector<node*> *retiring = NULL; // When set, reclaimed people are moved here instead of back to the arena.
 
         /*Private methods*/
-        void freeTree(node *root);
-        node* getChild(string who,bool found, node *root);
-        node* search(string who, node *root);
-        relation_data search(string who,int currentDepth, position pos, node *root);
-        node* search(relation_data data ,int currentDepth, position pos ,node *root);
-        vector<string> split(const string& s, char delimiter);
-        relation_data getRelationData(vector<string> relation);
-        string relationDataToString(relation_data data);
+        void reclaim(size_t limit);
+        bool alive(const node *person) const;
+        status unlink(string_view name, node *&person);
+        node* attach(node *son, uint32_t symbol, position pos);
+        string_view nameOf(const node *person) const;
+        status vacancy(string_view to, position pos, node *&son);
+        void addToIndex(node *person);
+        void removeFromIndex(node *person);
+        node* search(string_view who) const;
+        node* firstNamed(uint32_t symbol) const;
+        node* firstAlive(const vector<node*> &people) const;
+        node* firstNumbered(relation_data data) const;
+        node* search(relation_data data) const;
+        node* search(relation_data data, size_t threads) const;
+        relation_data relationOf(string_view who) const;
 
     public:
-        Tree(string root);
+        Tree(string &&root, storage engine = storage::linked, shared_ptr<SymbolTable> symbols = NULL);
+        Tree(string_view root, storage engine = storage::linked, shared_ptr<SymbolTable> symbols = NULL);
+        Tree(const char *root, storage engine = storage::linked, shared_ptr<SymbolTable> symbols = NULL);
         ~Tree();
 
-        Tree& addFather(string to, string name);
-        Tree& addMother(string to, string name);
+        static unique_ptr<Tree> loadCsv(const string &path, storage engine = storage::linked);
+        static unique_ptr<Tree> load(const string &path, shared_ptr<SymbolTable> symbols = NULL);
+        void save(const string &path) const;
+
+        shared_ptr<SymbolTable> symbolTable() const;
+
+        Tree& addFather(string_view to, string &&name);
+        Tree& addFather(string_view to, string_view name);
+        Tree& addFather(string_view to, const char *name);
+        Tree& addMother(string_view to, string &&name);
+        Tree& addMother(string_view to, string_view name);
+        Tree& addMother(string_view to, const char *name);
 
         void display();
-        string relation(string who);
-        string find(string relation);
-        void remove(string name);
+        void display(ostream &out) const;
+        void exportDot(ostream &out) const;
+        void exportJsonLines(ostream &out) const;
+        string relation(string_view who) const;
+        size_t relation(string_view who, char *buffer, size_t size) const;
+        string find(string_view relation) const;
+        void remove(string_view name);
+        bool compact(size_t limit = SIZE_MAX);
+
+        vector<string> relations(span<const string_view> names) const;
+        vector<find_result> findAll(span<const string_view> relations) const;
+
+        status tryAddFather(string_view to, string &&name);
+        status tryAddFather(string_view to, string_view name);
+        status tryAddFather(string_view to, const char *name);
+        status tryAddMother(string_view to, string &&name);
+        status tryAddMother(string_view to, string_view name);
+        status tryAddMother(string_view to, const char *name);
+        find_result tryFind(string_view relation, size_t threads = 1) const;
+        status tryRemove(string_view name);
     };
 }
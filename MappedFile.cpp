@@ -0,0 +1,60 @@
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MappedFile.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* Outline constructor - maps a file.
+* param 1: path - the file path.
+*/
+MappedFile::MappedFile(const string &path){
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw system_error(errno, generic_category(), "cannot open " + path);
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        int error = errno;
+        close(fd);
+        throw system_error(error, generic_category(), "cannot stat " + path);
+    }
+    length = info.st_size;
+    if(length > 0){
+        void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED){
+            int error = errno;
+            close(fd);
+            throw system_error(error, generic_category(), "cannot map " + path);
+        }
+        begin = static_cast<const char*>(mapping);
+    }
+    close(fd); // The mapping keeps the file alive.
+}
+
+/*Outline destructor - unmaps the file*/
+MappedFile::~MappedFile(){
+    if(begin != NULL){
+        munmap(const_cast<char*>(begin), length);
+    }
+}
+
+/*
+* data / size / text - the mapped bytes.
+*/
+const char* MappedFile::data() const{
+    return begin;
+}
+
+size_t MappedFile::size() const{
+    return length;
+}
+
+string_view MappedFile::text() const{
+    return string_view(begin, length);
+}
@@ -0,0 +1,33 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+using namespace std;
+
+namespace family{
+    /*
+    * MappedFile - a whole file mapped read only into memory (POSIX mmap), unmapped on destruction.
+    * The constructor throws system_error when the file can't be opened or mapped.
+    */
+    class MappedFile{
+    private:
+        /*Private variables*/
+        const char *begin = NULL; // NULL for an empty file.
+        size_t length = 0;
+
+    public:
+        MappedFile(const string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const;
+        size_t size() const;
+        string_view text() const;
+    };
+}
@@ -0,0 +1,201 @@
+#include "MappedTree.hpp"
+#include <stdexcept>
+#include "OutputBuffer.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* Outline constructor - maps a snapshot file.
+* param 1: path - a file written by Tree::save.
+* param 2: verifyChecksum - true to read the whole file once and verify its checksum.
+* throws invalid_argument when the file isn't a valid snapshot and system_error when it can't be mapped.
+*/
+MappedTree::MappedTree(const string &path, bool verifyChecksum) : file(path), path(path){
+    const char *data = file.data();
+    header = &checkSnapshot(data, file.size(), path, verifyChecksum);
+    snapshot_layout layout = layoutOf(*header);
+    nameRef = reinterpret_cast<const uint64_t*>(data + layout.nameRef);
+    buckets = reinterpret_cast<const uint32_t*>(data + layout.buckets);
+    firstOf = reinterpret_cast<const uint32_t*>(data + layout.firstOf);
+    symbol = reinterpret_cast<const uint32_t*>(data + layout.symbol);
+    father = reinterpret_cast<const uint32_t*>(data + layout.father);
+    mother = reinterpret_cast<const uint32_t*>(data + layout.mother);
+    child = reinterpret_cast<const uint32_t*>(data + layout.child);
+    relationKey = reinterpret_cast<const uint32_t*>(data + layout.relationKey);
+    blob = data + layout.blob;
+}
+
+/*
+* size - the number of people.
+*/
+size_t MappedTree::size() const{
+    return header->people;
+}
+
+/*
+* corrupt - throws the error Tree::load throws for a corrupt snapshot.
+*/
+void MappedTree::corrupt() const{
+    throw invalid_argument(path + ": corrupt snapshot");
+}
+
+/*
+* nameOfSymbol - a name of the file's name table.
+* throws invalid_argument when the symbol or its offsets are out of the file's tables.
+*/
+string_view MappedTree::nameOfSymbol(uint32_t s) const{
+    if(s >= header->names || nameRef[s] > nameRef[s + 1] || nameRef[s + 1] > header->blobSize){
+        corrupt();
+    }
+    return string_view(blob + nameRef[s], nameRef[s + 1] - nameRef[s]);
+}
+
+/*
+* nameOf / fatherOf / motherOf / childOf - access a person by index (links are NONE when missing).
+*/
+string_view MappedTree::nameOf(uint32_t person) const{
+    if(person >= header->people){
+        corrupt();
+    }
+    return nameOfSymbol(symbol[person]);
+}
+
+uint32_t MappedTree::fatherOf(uint32_t person) const{
+    return father[person];
+}
+
+uint32_t MappedTree::motherOf(uint32_t person) const{
+    return mother[person];
+}
+
+uint32_t MappedTree::childOf(uint32_t person) const{
+    return child[person];
+}
+
+/*
+* relationOf - relation information of a person.
+* param 1: person - an index.
+*/
+relation_data MappedTree::relationOf(uint32_t person) const{
+    relation_data data;
+    data.valid = true;
+    data.depth = relationKey[person] / 2;
+    data.pos = data.depth == 0 ? self : (relationKey[person] & 1) ? mother_pos : father_pos;
+    return data;
+}
+
+/*
+* search - a lookup in the file's name hash table.
+* param 1: who - the person who need to be found.
+* return value: the index of the person the saved tree found by this name Or NONE.
+* throws invalid_argument when the table is corrupt (the probe gives up after visiting every bucket once).
+*/
+uint32_t MappedTree::search(string_view who) const{
+    uint64_t mask = header->buckets - 1;
+    uint64_t bucket = fingerprintOf(who) & mask;
+    for(uint64_t probes = 0; probes < header->buckets && buckets[bucket] != NONE; probes++, bucket = (bucket + 1) & mask){
+        if(nameOfSymbol(buckets[bucket]) == who){
+            uint32_t person = firstOf[buckets[bucket]];
+            if(person >= header->people){
+                corrupt();
+            }
+            return person;
+        }
+        if(probes + 1 == header->buckets){
+            corrupt(); // No empty bucket at all.
+        }
+    }
+    return NONE;
+}
+
+/*
+* search - a sequential scan for a relation.
+* param 1: data - relation data object.
+* return value: the index of the first person in preorder matching the relation Or NONE.
+*/
+uint32_t MappedTree::search(relation_data data) const{
+    uint32_t key = (uint32_t)data.depth * 2 + (data.pos == mother_pos ? 1 : 0);
+    for(uint32_t i = 0; i < header->people; i++){
+        if(relationKey[i] == key){
+            return i;
+        }
+    }
+    return NONE;
+}
+
+/*
+* display - prints the tree in preorder and writes relevant relation info (same output as Tree::display).
+*/
+void MappedTree::display() const{
+    display(cout);
+    cout.flush();
+}
+
+/*
+* display - writes the tree to a stream, buffered and without flushing it (see Tree::display).
+*/
+void MappedTree::display(ostream &out) const{
+    OutputBuffer text(out);
+    for(uint32_t i = 0; i < header->people; i++){
+        if(child[i] == NONE){
+            text << nameOf(i) << '\n';
+        }else{
+            text << nameOf(child[i]) << "'s " << (relationKey[i] & 1 ? "mother" : "father") << ": " << nameOf(i) << '\n';
+        }
+    }
+}
+
+/*
+* relation - get relation information (father/mother...granfather..).
+* param 1: who - a name of person.
+* return value: string which represents a relation Or "unrelated".
+*/
+string MappedTree::relation(string_view who) const{
+    uint32_t person = search(who);
+    relation_data data;
+    data.valid = false;
+    return relationToString(person == NONE ? data : relationOf(person));
+}
+
+/*
+* relation - writes relation information into a caller provided buffer (see writeRelation).
+*/
+size_t MappedTree::relation(string_view who, char *buffer, size_t size) const{
+    uint32_t person = search(who);
+    relation_data data;
+    data.valid = false;
+    return writeRelation(person == NONE ? data : relationOf(person), buffer, size);
+}
+
+/*
+* tryFind - search person's name by given relation type, without throwing.
+* param 1: relation - a relation type (Example: "grandfather").
+* return value: find_result - the name (a view into the mapping) on success,
+*               otherwise status::bad_relation or status::relation_not_found.
+*/
+find_result MappedTree::tryFind(string_view relation) const{
+    find_result result;
+    relation_data data = parseRelation(relation);
+    if(!data.valid){
+        result.code = status::bad_relation;
+        return result;
+    }
+    uint32_t person = search(data);
+    result.code = person == NONE ? status::relation_not_found : status::ok;
+    if(person != NONE){
+        result.name = nameOf(person);
+    }
+    return result;
+}
+
+/*
+* find - search person's name by given relation type.
+* param 1: relation - a relation type (Example: "grandfather").
+* return value: string (name).
+*/
+string MappedTree::find(string_view relation) const{
+    find_result result = tryFind(relation);
+    throwIfFailed(result.code);
+    return string(result.name);
+}
@@ -0,0 +1,65 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "FamilyTree.hpp"
+#include "MappedFile.hpp"
+#include "Snapshot.hpp"
+using namespace std;
+
+namespace family{
+    /*
+    * MappedTree - a read only tree which answers queries straight from a mapped snapshot file (see Tree::save).
+    * Nothing is copied or allocated when the file is opened: people are preorder indices into the mapped arrays,
+    * names are found through the file's hash table, and processes which map the same file share its page cache.
+    * Opening checks only the header, unless the checksum is requested. Every index read from the file is range checked
+    * when it is used, so a corrupt file throws invalid_argument (like Tree::load) instead of reading out of the mapping.
+    */
+    class MappedTree{
+    public:
+        static constexpr uint32_t NONE = SNAPSHOT_NONE;
+
+    private:
+        /*Private variables*/
+        MappedFile file;
+        string path;
+        const snapshot_header *header;
+        const uint64_t *nameRef;
+        const uint32_t *buckets;
+        const uint32_t *firstOf;
+        const uint32_t *symbol;
+        const uint32_t *father;
+        const uint32_t *mother;
+        const uint32_t *child;
+        const uint32_t *relationKey;
+        const char *blob;
+
+        /*Private methods*/
+        [[noreturn]] void corrupt() const;
+        string_view nameOfSymbol(uint32_t s) const;
+        uint32_t search(relation_data data) const;
+
+    public:
+        MappedTree(const string &path, bool verifyChecksum = false);
+
+        size_t size() const;
+        string_view nameOf(uint32_t person) const;
+        uint32_t fatherOf(uint32_t person) const;
+        uint32_t motherOf(uint32_t person) const;
+        uint32_t childOf(uint32_t person) const;
+        relation_data relationOf(uint32_t person) const;
+        uint32_t search(string_view who) const;
+
+        void display() const;
+        void display(ostream &out) const;
+        string relation(string_view who) const;
+        size_t relation(string_view who, char *buffer, size_t size) const;
+        find_result tryFind(string_view relation) const;
+        string find(string_view relation) const;
+    };
+}
@@ -0,0 +1,90 @@
+#include <new>
+#include <type_traits>
+#include "NodeArena.hpp"
+#include "FamilyTree.hpp"
+
+using namespace std;
+using namespace family;
+
+static const size_t MAX_CHUNK_SIZE = 65536; // Upper bound (in nodes) for a single chunk.
+
+/*Outline constructor - creates an empty arena, the first chunk is allocated lazily*/
+NodeArena::NodeArena(size_t firstChunkSize){
+    nextChunkSize = firstChunkSize < 1 ? 1 : firstChunkSize;
+}
+
+static_assert(is_trivially_destructible<node>::value, "the arena releases nodes without destructing them");
+
+/*
+* Outline destructor - releases the memory chunk by chunk.
+*/
+NodeArena::~NodeArena(){
+    for(node *chunk : chunks){
+        ::operator delete(chunk);
+    }
+}
+
+/*
+* grow - allocates a new chunk and points the bump pointer at it.
+* param 1: slots - minimal number of nodes the new chunk must hold.
+*/
+void NodeArena::grow(size_t slots){
+    size_t size = nextChunkSize < slots ? slots : nextChunkSize;
+    node *chunk = static_cast<node*>(::operator new(size * sizeof(node)));
+    chunks.push_back(chunk);
+    next = chunk;
+    end = chunk + size;
+    if(nextChunkSize < MAX_CHUNK_SIZE){
+        nextChunkSize *= 2;
+    }
+}
+
+/*
+* allocate - get a node for a new person, reusing a released node when possible.
+* param 1: symbol - the person's name.
+* return value: node* - a node with no father, no mother and no child.
+*/
+node* NodeArena::allocate(uint32_t symbol){
+    node *n;
+    if(freeList != NULL){
+        n = freeList;
+        freeList = n->father;
+        n->symbol = symbol;
+        n->father = n->mother = n->child = NULL;
+    }else{
+        if(next == end){
+            grow(1);
+        }
+        n = new (next++) node(symbol);
+    }
+    live++;
+    return n;
+}
+
+/*
+* reserve - makes sure the next allocations of the given number of people don't need another chunk.
+* param 1: people - the number of people about to be allocated.
+*/
+void NodeArena::reserve(size_t people){
+    if((size_t)(end - next) < people){
+        grow(people); // The rest of the current chunk stays unused.
+    }
+}
+
+/*
+* release - returns a single node to the arena, to be reused by allocate().
+* param 1: n - a node that was allocated by this arena.
+*/
+void NodeArena::release(node *n){
+    n->mother = NULL;
+    n->father = freeList;
+    freeList = n;
+    live--;
+}
+
+/*
+* size - number of nodes currently in use.
+*/
+size_t NodeArena::size() const{
+    return live;
+}
@@ -0,0 +1,44 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+struct node;
+
+namespace family{
+    /*
+    * NodeArena - a chunked slab allocator for Tree nodes.
+    * Nodes are carved out of large chunks by a pointer bump, removed nodes are kept on a free list
+    * for reuse, and the whole arena is released chunk by chunk (nodes are trivially destructible) when the owning Tree is destroyed.
+    */
+    class NodeArena{
+    private:
+        /*Private variables*/
+        vector<node*> chunks;     // Every chunk ever allocated.
+        node *next = NULL;        // Bump pointer inside the newest chunk.
+        node *end = NULL;         // One past the last slot of the newest chunk.
+        node *freeList = NULL;    // Released nodes, linked through their 'father' pointer.
+        size_t nextChunkSize;
+        size_t live = 0;
+
+        /*Private methods*/
+        void grow(size_t slots);
+
+    public:
+        NodeArena(size_t firstChunkSize = 64);
+        ~NodeArena();
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        node* allocate(uint32_t symbol);
+        void reserve(size_t people);
+        void release(node *n);
+        size_t size() const;
+    };
+}
@@ -0,0 +1,96 @@
+#include <charconv>
+#include <cstring>
+#include "OutputBuffer.hpp"
+
+using namespace std;
+using namespace family;
+
+/*Outline constructor - an empty buffer in front of a stream*/
+OutputBuffer::OutputBuffer(ostream &out) : out(out){
+}
+
+/*Outline destructor - writes what is left*/
+OutputBuffer::~OutputBuffer(){
+    flush();
+}
+
+/*
+* flush - writes the buffered text to the stream (the stream itself isn't flushed).
+*/
+void OutputBuffer::flush(){
+    out.write(buffer, used);
+    used = 0;
+}
+
+/*
+* operator<< - appends text, a character or a decimal number.
+*/
+OutputBuffer& OutputBuffer::operator<<(string_view text){
+    if(used + text.size() > SIZE){
+        flush();
+        if(text.size() > SIZE){
+            out.write(text.data(), text.size());
+            return *this;
+        }
+    }
+    memcpy(buffer + used, text.data(), text.size());
+    used += text.size();
+    return *this;
+}
+
+OutputBuffer& OutputBuffer::operator<<(const char *text){
+    return *this << string_view(text);
+}
+
+OutputBuffer& OutputBuffer::operator<<(char c){
+    if(used == SIZE){
+        flush();
+    }
+    buffer[used++] = c;
+    return *this;
+}
+
+OutputBuffer& OutputBuffer::operator<<(uint64_t number){
+    char digits[20];
+    return *this << string_view(digits, to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+}
+
+/*
+* quoted - appends text as a double quoted JSON string, escaping quotes, backslashes and control characters.
+* param 1: text - the text.
+*/
+OutputBuffer& OutputBuffer::quoted(string_view text){
+    static const char hex[] = "0123456789abcdef";
+    *this << '"';
+    for(char c : text){
+        if(c == '"' || c == '\\'){
+            *this << '\\' << c;
+        }else if((unsigned char)c < 0x20){
+            *this << "\\u00" << hex[(unsigned char)c >> 4] << hex[c & 15];
+        }else{
+            *this << c;
+        }
+    }
+    return *this << '"';
+}
+
+/*
+* dotQuoted - appends text as a double quoted Graphviz label. quotes and backslashes are escaped, a newline becomes
+* the label line break \n and other control characters (which DOT can't escape) are replaced by spaces.
+* param 1: text - the text.
+*/
+OutputBuffer& OutputBuffer::dotQuoted(string_view text){
+    *this << '"';
+    for(char c : text){
+        if(c == '"' || c == '\\'){
+            *this << '\\' << c;
+        }else if(c == '\n'){
+            *this << "\\n";
+        }else if((unsigned char)c < 0x20 || c == 0x7f){
+            *this << ' ';
+        }else{
+            *this << c;
+        }
+    }
+    return *this << '"';
+}
@@ -0,0 +1,43 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+using namespace std;
+
+namespace family{
+    /*
+    * OutputBuffer - collects text in a large fixed buffer and hands it to an ostream in big blocks,
+    * so writing a tree costs one stream call per block instead of one (plus a flush) per person.
+    * The remaining text is written (without flushing the stream) when the buffer is destroyed.
+    */
+    class OutputBuffer{
+    public:
+        static constexpr size_t SIZE = 65536;
+
+    private:
+        /*Private variables*/
+        ostream &out;
+        size_t used = 0;
+        char buffer[SIZE];
+
+    public:
+        OutputBuffer(ostream &out);
+        ~OutputBuffer();
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        OutputBuffer& operator<<(string_view text);
+        OutputBuffer& operator<<(const char *text);
+        OutputBuffer& operator<<(char c);
+        OutputBuffer& operator<<(uint64_t number);
+        OutputBuffer& quoted(string_view text);
+        OutputBuffer& dotQuoted(string_view text);
+        void flush();
+    };
+}
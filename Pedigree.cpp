@@ -0,0 +1,194 @@
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include "Pedigree.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* slot - an empty father/mother slot of a person who can be addressed by name.
+*/
+struct slot {
+    size_t person;
+    position pos;
+};
+
+/*
+* fullPedigree - a full binary pedigree.
+* param 1: depth - the number of generations above the root (2^(depth+1)-1 people in total).
+* return value: the pedigree, with people named by their Ahnentafel number (root "p1", his father "p2", ...).
+* throws invalid_argument when the depth is negative or above AhnentafelIndex::MAX_DEPTH (the names would overflow).
+*/
+pedigree family::fullPedigree(int depth){
+    if(depth < 0 || depth > AhnentafelIndex::MAX_DEPTH){
+        throw invalid_argument("full pedigree depth must be between 0 and " + to_string(AhnentafelIndex::MAX_DEPTH));
+    }
+    pedigree result;
+    result.root = "p1";
+    uint64_t people = (uint64_t(1) << (depth + 1)) - 1;
+    for(uint64_t k = 1; 2*k <= people; k++){
+        string to = "p" + to_string(k);
+        result.operations.push_back({father_pos, to, "p" + to_string(2*k)});
+        result.operations.push_back({mother_pos, to, "p" + to_string(2*k+1)});
+    }
+    return result;
+}
+
+/*
+* chainPedigree - a single line of ancestors.
+* param 1: generations - the number of ancestors above the root.
+* param 2: side - father_pos for a line of fathers, mother_pos for a line of mothers.
+* return value: the pedigree, with people named g0 (the root), g1, g2 ...
+*/
+pedigree family::chainPedigree(size_t generations, position side){
+    pedigree result;
+    result.root = "g0";
+    for(size_t i = 0; i < generations; i++){
+        result.operations.push_back({side, "g" + to_string(i), "g" + to_string(i+1)});
+    }
+    return result;
+}
+
+/*
+* grow - attaches people one by one to a random free slot.
+* param 1: people - the total number of people (root included).
+* param 2: repeatRate - the probability that a new person reuses a name which is already in the tree.
+* param 3: prefix - the prefix of fresh names.
+* param 4: seed - the random seed.
+*/
+static pedigree grow(size_t people, double repeatRate, const string &prefix, uint64_t seed){
+    mt19937_64 random(seed);
+    const uint64_t repeatThreshold = (uint64_t)(repeatRate * 1000000);
+    pedigree result;
+    vector<string> names;   // Per person.
+    vector<size_t> firsts;  // The people whose name was fresh when they were added.
+    vector<slot> slots;
+
+    result.root = prefix + "0";
+    names.push_back(result.root);
+    firsts.push_back(0);
+    slots.push_back({0, father_pos});
+    slots.push_back({0, mother_pos});
+
+    for(size_t i = 1; i < people; i++){
+        size_t pick = random() % slots.size();
+        slot free = slots.at(pick);
+        slots.at(pick) = slots.back();
+        slots.pop_back();
+
+        // Reusing a name makes a leaf, so never do it when that would leave no free slot.
+        bool repeat = !slots.empty() && random() % 1000000 < repeatThreshold;
+        string name = repeat ? names.at(firsts.at(random() % firsts.size())) : prefix + to_string(i);
+        result.operations.push_back({free.pos, names.at(free.person), name});
+        names.push_back(name);
+        if(!repeat){
+            firsts.push_back(i);
+            slots.push_back({i, father_pos});
+            slots.push_back({i, mother_pos});
+        }
+    }
+    return result;
+}
+
+/*
+* sparsePedigree - a random pedigree with unique names (s0 is the root).
+* param 1: people - the number of people (root included).
+* param 2: seed - the random seed.
+*/
+pedigree family::sparsePedigree(size_t people, uint64_t seed){
+    return grow(people, 0, "s", seed);
+}
+
+/*
+* collapsedPedigree - a random pedigree with repeated names (n0 is the root).
+* param 1: people - the number of people (root included).
+* param 2: repeatRate - the probability (0..1) that a new person reuses an existing name.
+* param 3: seed - the random seed.
+*/
+pedigree family::collapsedPedigree(size_t people, double repeatRate, uint64_t seed){
+    return grow(people, repeatRate, "n", seed);
+}
+
+/*
+* replay - builds a pedigree directly into a tree.
+* param 1: input - the pedigree.
+* param 2: T - a tree whose root is input.root.
+*/
+void family::replay(const pedigree &input, Tree &T){
+    for(const operation &op : input.operations){
+        if(op.pos == father_pos){
+            T.addFather(op.to, string_view(op.name));
+        }else{
+            T.addMother(op.to, string_view(op.name));
+        }
+    }
+}
+
+/*
+* writeScript - writes a pedigree as an operation script:
+*   root <name>
+*   father <to> <name>
+*   mother <to> <name>
+* param 1: input - the pedigree (names must not contain white space).
+* param 2: out - the output stream.
+*/
+void family::writeScript(const pedigree &input, ostream &out){
+    out << "root " << input.root << '\n';
+    for(const operation &op : input.operations){
+        out << (op.pos == father_pos ? "father " : "mother ") << op.to << ' ' << op.name << '\n';
+    }
+}
+
+/*
+* writeCsv - writes a pedigree as an edge list, one "child,father,mother" row per person who has parents,
+* in the format Tree::loadCsv reads.
+* param 1: input - the pedigree (every name must be unique, so collapsed pedigrees can't be written).
+* param 2: out - the output stream.
+*/
+void family::writeCsv(const pedigree &input, ostream &out){
+    vector<string_view> children;
+    vector<pair<string_view, string_view>> parents;
+    unordered_map<string_view, size_t> rowOf;
+    rowOf.reserve(input.operations.size());
+    for(const operation &op : input.operations){
+        auto row = rowOf.emplace(op.to, children.size());
+        if(row.second){
+            children.push_back(op.to);
+            parents.emplace_back();
+        }
+        (op.pos == father_pos ? parents[row.first->second].first : parents[row.first->second].second) = op.name;
+    }
+    out << "child,father,mother\n";
+    if(children.empty()){
+        out << input.root << ",,\n";
+    }
+    for(size_t i = 0; i < children.size(); i++){
+        out << children[i] << ',' << parents[i].first << ',' << parents[i].second << '\n';
+    }
+}
+
+/*
+* readScript - reads an operation script written by writeScript.
+* param 1: in - the input stream.
+* return value: the pedigree. throws invalid_argument on a malformed script.
+*/
+pedigree family::readScript(istream &in){
+    pedigree result;
+    string command;
+    if(!(in >> command >> result.root) || command != "root"){
+        throw invalid_argument("pedigree script must start with 'root <name>'");
+    }
+    operation op;
+    while(in >> command >> op.to >> op.name){
+        if(command == "father"){
+            op.pos = father_pos;
+        }else if(command == "mother"){
+            op.pos = mother_pos;
+        }else{
+            throw invalid_argument("unknown pedigree script command: " + command);
+        }
+        result.operations.push_back(op);
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "FamilyTree.hpp"
+using namespace std;
+
+namespace family{
+    /*
+    * operation - a single addFather (pos = father_pos) or addMother (pos = mother_pos) call.
+    */
+    struct operation {
+        position pos;
+        string to;
+        string name;
+    };
+
+    /*
+    * pedigree - a synthetic input: the root's name and the operations that build the rest of the tree, in a valid order.
+    */
+    struct pedigree {
+        string root;
+        vector<operation> operations;
+    };
+
+    /*
+    * Seeded pedigree generators. The same arguments always produce the same pedigree (on every platform).
+    * fullPedigree - every person up to the given depth has both parents, people are named p<Ahnentafel number>.
+    * chainPedigree - a single line of fathers (or mothers) of the given length.
+    * sparsePedigree - people attached one by one to a random free father/mother slot.
+    * collapsedPedigree - like sparsePedigree but a share of the people reuse the name of someone already in the tree
+    *                     (a repeated name is always a leaf, since addFather/addMother resolve a name to its first person).
+    */
+    pedigree fullPedigree(int depth);
+    pedigree chainPedigree(size_t generations, position side = father_pos);
+    pedigree sparsePedigree(size_t people, uint64_t seed);
+    pedigree collapsedPedigree(size_t people, double repeatRate, uint64_t seed);
+
+    void replay(const pedigree &input, Tree &T);
+    void writeScript(const pedigree &input, ostream &out);
+    void writeCsv(const pedigree &input, ostream &out);
+    pedigree readScript(istream &in);
+}
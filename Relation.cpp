@@ -0,0 +1,195 @@
+#include <cstdint>
+#include <cstring>
+#include "Relation.hpp"
+
+using namespace std;
+using namespace family;
+
+static const string_view GREAT = "great-";
+static const string_view UNRELATED = "unrelated";
+static constexpr int CACHED_DEPTH = 64; // Relations of the first generations are rendered at compile time.
+
+/*
+* makeRelation - builds a valid relation_data object.
+*/
+static relation_data makeRelation(int depth, position pos){
+    relation_data data;
+    data.valid = true;
+    data.depth = depth;
+    data.pos = pos;
+    return data;
+}
+
+/*
+* parseRelation - creates relation_data object from a relation string (Example: "great-great-grandfather").
+* Accepts "me", "father", "mother" and [great-]*grand(father|mother) in a single pass without allocating.
+* param 1: relation - the relation string.
+* return value: data - relation_data object, data.valid is false when the string violates the syntax.
+*/
+relation_data family::parseRelation(string_view relation){
+    if(relation == "me"){
+        return makeRelation(0, self);
+    }else if(relation == "father"){
+        return makeRelation(1, father_pos);
+    }else if(relation == "mother"){
+        return makeRelation(1, mother_pos);
+    }
+    int greats = 0;
+    while(relation.compare(0, GREAT.size(), GREAT) == 0){
+        relation.remove_prefix(GREAT.size());
+        greats++;
+    }
+    if(relation == "grandfather"){
+        return makeRelation(greats + 2, father_pos);
+    }else if(relation == "grandmother"){
+        return makeRelation(greats + 2, mother_pos);
+    }
+    relation_data data;
+    data.valid = false;
+    data.depth = 0;
+    data.pos = self;
+    return data;
+}
+
+/*
+* append - copies a piece of text into a bounded buffer.
+* param 1: text - the text to copy.
+* param 2: buffer / size - the destination buffer and its size.
+* param 3: at - the offset in the rendered relation where the text starts.
+*/
+static void append(string_view text, char *buffer, size_t size, size_t at){
+    if(at + 1 < size){
+        size_t room = size - 1 - at;
+        memcpy(buffer + at, text.data(), text.size() < room ? text.size() : room);
+    }
+}
+
+/*
+* render - builds the string of a relation piece by piece into a bounded buffer (see writeRelation).
+*/
+static size_t render(relation_data data, char *buffer, size_t size){
+    size_t length = 0;
+    if(!data.valid){
+        append(UNRELATED, buffer, size, length);
+        length += UNRELATED.size();
+    }else if(data.depth == 0){
+        append("me", buffer, size, length);
+        length += 2;
+    }else{
+        for(int i = 0; i < data.depth - 2; i++){
+            append(GREAT, buffer, size, length);
+            length += GREAT.size();
+        }
+        if(data.depth >= 2){
+            append("grand", buffer, size, length);
+            length += 5;
+        }
+        append(data.pos == father_pos ? "father" : "mother", buffer, size, length);
+        length += 6;
+    }
+    if(size > 0){
+        buffer[length < size ? length : size - 1] = '\0';
+    }
+    return length;
+}
+
+/*
+* relationLength - the length of the string of a relation of the given depth.
+*/
+static constexpr size_t relationLength(int depth){
+    return depth == 0 ? 2 : depth == 1 ? 6 : 6 * (depth - 2) + 11;
+}
+
+static constexpr size_t cachedSize(){
+    size_t total = 0;
+    for(int depth = 0; depth < CACHED_DEPTH; depth++){
+        total += 2 * relationLength(depth);
+    }
+    return total;
+}
+
+/*
+* relation_table - the relation strings of the first CACHED_DEPTH generations, back to back.
+* The string of depth*2 + side (1 for the mother's side) starts at offset[depth*2 + side] and ends where the next starts.
+*/
+struct relation_table {
+    char text[cachedSize()];
+    uint32_t offset[CACHED_DEPTH * 2 + 1];
+};
+
+/*
+* buildRelations - renders the cached relations at compile time, so using them never allocates or initializes anything.
+*/
+static constexpr relation_table buildRelations(){
+    relation_table table{};
+    size_t at = 0;
+    auto put = [&table, &at](const char *text){
+        while(*text != '\0'){
+            table.text[at++] = *text++;
+        }
+    };
+    for(int depth = 0; depth < CACHED_DEPTH; depth++){
+        for(int side = 0; side < 2; side++){
+            table.offset[depth * 2 + side] = at;
+            if(depth == 0){
+                put("me");
+                continue;
+            }
+            for(int i = 0; i < depth - 2; i++){
+                put("great-");
+            }
+            if(depth >= 2){
+                put("grand");
+            }
+            put(side == 1 ? "mother" : "father");
+        }
+    }
+    table.offset[CACHED_DEPTH * 2] = at;
+    return table;
+}
+
+static constexpr relation_table CACHED_RELATIONS = buildRelations();
+
+/*
+* cachedRelation - the string of a relation of the first CACHED_DEPTH generations.
+*/
+static string_view cachedRelation(relation_data data){
+    size_t i = data.depth * 2 + (data.pos == mother_pos ? 1 : 0);
+    return string_view(CACHED_RELATIONS.text + CACHED_RELATIONS.offset[i], CACHED_RELATIONS.offset[i + 1] - CACHED_RELATIONS.offset[i]);
+}
+
+/*
+* writeRelation - writes the string of a relation (Example: "great-great-grandmother") into a caller provided buffer.
+* Works like snprintf: at most size-1 characters are written and the buffer is always NUL terminated (when size > 0).
+* An invalid relation_data object is written as "unrelated".
+* param 1: data - relation_data object.
+* param 2: buffer - the destination buffer.
+* param 3: size - the size of the destination buffer.
+* return value: the length of the full relation string (a result >= size means the output was truncated).
+*/
+size_t family::writeRelation(relation_data data, char *buffer, size_t size){
+    if(data.valid && data.depth < CACHED_DEPTH){
+        string_view cached = cachedRelation(data);
+        append(cached, buffer, size, 0);
+        if(size > 0){
+            buffer[cached.size() < size ? cached.size() : size - 1] = '\0';
+        }
+        return cached.size();
+    }
+    return render(data, buffer, size);
+}
+
+/*
+* relationToString - the inverse function of 'parseRelation'. the function constructs a string from realtion_data object.
+* Relations of the first generations are copied from a cache instead of being rebuilt.
+* param 1: data - relation_data object.
+* return value: a string which describes a relation (Example: "great-great-grandmother"), "unrelated" for invalid data.
+*/
+string family::relationToString(relation_data data){
+    if(data.valid && data.depth < CACHED_DEPTH){
+        return string(cachedRelation(data));
+    }
+    string to_return(render(data, NULL, 0), ' ');
+    render(data, to_return.data(), to_return.size() + 1);
+    return to_return;
+}
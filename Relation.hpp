@@ -0,0 +1,26 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+using namespace std;
+
+enum position {
+    self, father_pos, mother_pos
+};
+
+struct relation_data {
+    bool valid;
+    int depth;
+    position pos;
+};
+
+namespace family{
+    relation_data parseRelation(string_view relation);
+    string relationToString(relation_data data);
+    size_t writeRelation(relation_data data, char *buffer, size_t size);
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include "FamilyTree.hpp"
+#include "MappedFile.hpp"
+#include "Snapshot.hpp"
+#include "Traversal.hpp"
+
+using namespace std;
+using namespace family;
+
+/* Rounds a section size up to the 8 byte alignment of the next section. */
+static size_t aligned(size_t size){
+    return (size + 7) & ~size_t(7);
+}
+
+/*
+* layoutOf - the file offset of every section of a snapshot.
+* param 1: header - a header whose counts were already checked against the file size.
+*/
+snapshot_layout family::layoutOf(const snapshot_header &header){
+    snapshot_layout layout;
+    layout.nameRef = sizeof(snapshot_header);
+    layout.buckets = layout.nameRef + (header.names + 1) * sizeof(uint64_t);
+    layout.firstOf = layout.buckets + aligned(header.buckets * sizeof(uint32_t));
+    size_t people = aligned(header.people * sizeof(uint32_t));
+    layout.symbol = layout.firstOf + aligned(header.names * sizeof(uint32_t));
+    layout.father = layout.symbol + people;
+    layout.mother = layout.father + people;
+    layout.child = layout.mother + people;
+    layout.relationKey = layout.child + people;
+    layout.blob = layout.relationKey + people;
+    layout.size = layout.blob + header.blobSize;
+    return layout;
+}
+
+/*
+* checksumOf - a 64 bit FNV-1a style checksum, taken a word at a time.
+* param 1: data - the bytes.
+* param 2: size - the number of bytes.
+*/
+uint64_t family::checksumOf(const char *data, size_t size){
+    uint64_t hash = 14695981039346656037ull;
+    size_t i = 0;
+    for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)){
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for(; i < size; i++){
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/*
+* checkSnapshot - validates the header, the size and the checksum of a snapshot.
+* param 1: data - the whole file (8 byte aligned).
+* param 2: size - the file size.
+* param 3: path - the file path, for error messages.
+* param 4: verifyChecksum - false to check only the header (O(1), without touching the rest of the file).
+* return value: the header. throws invalid_argument when the file isn't a valid snapshot.
+*/
+const snapshot_header& family::checkSnapshot(const char *data, size_t size, const string &path, bool verifyChecksum){
+    if(size < sizeof(snapshot_header) || memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0){
+        throw invalid_argument(path + ": not a family tree snapshot");
+    }
+    const snapshot_header &header = *reinterpret_cast<const snapshot_header*>(data);
+    if(header.byteOrder != SNAPSHOT_BYTE_ORDER){
+        throw invalid_argument(path + ": snapshot was written on a machine of another byte order");
+    }
+    if(header.version != SNAPSHOT_VERSION){
+        throw invalid_argument(path + ": unsupported snapshot version " + to_string(header.version));
+    }
+    bool sane = header.people >= 1 && header.people < SNAPSHOT_NONE && header.names < SNAPSHOT_NONE
+                && header.blobSize <= size && header.buckets <= size && header.buckets >= 2 * header.names
+                && (header.buckets & (header.buckets - 1)) == 0 && header.engine <= (uint32_t)storage::ahnentafel;
+    if(!sane || layoutOf(header).size != size){
+        throw invalid_argument(path + ": corrupt snapshot header");
+    }
+    if(verifyChecksum && checksumOf(data + sizeof(snapshot_header), size - sizeof(snapshot_header)) != header.checksum){
+        throw invalid_argument(path + ": snapshot checksum mismatch");
+    }
+    return header;
+}
+
+/*
+* save - writes the tree as a binary snapshot (see Snapshot.hpp), with only the names the tree uses.
+* param 1: path - the file path (overwritten).
+* throws runtime_error when the file can't be written.
+*/
+void Tree::save(const string &path) const{
+    vector<node*> people;
+    unordered_map<const node*, uint32_t> indexOf;
+    indexOf.reserve(nodes.size());
+    people.reserve(nodes.size());
+    preorder(root, [&](node *person){
+        indexOf[person] = people.size();
+        people.push_back(person);
+        return false;
+    });
+
+    vector<uint32_t> renamed(symbols->size(), SNAPSHOT_NONE); // Pool symbol -> snapshot symbol.
+    vector<uint32_t> used;                                    // Snapshot symbol -> pool symbol.
+    vector<uint32_t> firstOf;
+    snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.engine = numbers != NULL ? (uint32_t)storage::ahnentafel : (uint32_t)storage::linked;
+    header.people = people.size();
+    for(uint32_t i = 0; i < people.size(); i++){
+        uint32_t &symbol = renamed[people[i]->symbol];
+        if(symbol == SNAPSHOT_NONE){
+            symbol = used.size();
+            used.push_back(people[i]->symbol);
+            firstOf.push_back(indexOf.at(firstNamed(people[i]->symbol)));
+            header.blobSize += symbols->name(people[i]->symbol).size();
+        }
+    }
+    header.names = used.size();
+    header.buckets = 2;
+    while(header.buckets < 2 * header.names){
+        header.buckets *= 2;
+    }
+
+    snapshot_layout layout = layoutOf(header);
+    vector<char> image(layout.size, 0);
+    uint64_t *nameRef = reinterpret_cast<uint64_t*>(&image[layout.nameRef]);
+    uint32_t *buckets = reinterpret_cast<uint32_t*>(&image[layout.buckets]);
+    char *blob = &image[layout.blob];
+    uint64_t offset = 0;
+    fill(buckets, buckets + header.buckets, SNAPSHOT_NONE);
+    for(uint32_t s = 0; s < used.size(); s++){
+        string_view name = symbols->name(used[s]);
+        nameRef[s] = offset;
+        memcpy(blob + offset, name.data(), name.size());
+        offset += name.size();
+        uint64_t bucket = fingerprintOf(name) & (header.buckets - 1);
+        while(buckets[bucket] != SNAPSHOT_NONE){
+            bucket = (bucket + 1) & (header.buckets - 1);
+        }
+        buckets[bucket] = s;
+    }
+    nameRef[used.size()] = offset;
+    memcpy(&image[layout.firstOf], firstOf.data(), firstOf.size() * sizeof(uint32_t));
+
+    uint32_t *symbol = reinterpret_cast<uint32_t*>(&image[layout.symbol]);
+    uint32_t *father = reinterpret_cast<uint32_t*>(&image[layout.father]);
+    uint32_t *mother = reinterpret_cast<uint32_t*>(&image[layout.mother]);
+    uint32_t *child = reinterpret_cast<uint32_t*>(&image[layout.child]);
+    uint32_t *relationKey = reinterpret_cast<uint32_t*>(&image[layout.relationKey]);
+    for(uint32_t i = 0; i < people.size(); i++){
+        node *person = people[i];
+        symbol[i] = renamed[person->symbol];
+        father[i] = person->father != NULL ? indexOf.at(person->father) : SNAPSHOT_NONE;
+        mother[i] = person->mother != NULL ? indexOf.at(person->mother) : SNAPSHOT_NONE;
+        child[i] = person->child != NULL ? indexOf.at(person->child) : SNAPSHOT_NONE;
+        relationKey[i] = (uint32_t)person->depth * 2 + (person->pos == mother_pos ? 1 : 0);
+    }
+
+    header.checksum = checksumOf(image.data() + sizeof(header), image.size() - sizeof(header));
+    memcpy(image.data(), &header, sizeof(header));
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(image.data(), image.size());
+    out.close();
+    if(!out){
+        throw runtime_error("cannot write " + path);
+    }
+}
+
+/*
+* load - reads a tree from a binary snapshot written by save().
+* The file is mapped and checked once, every name is interned once and the nodes come from a single arena chunk.
+* A name shared by several people keeps finding the first of them in preorder, as before the tree was saved.
+* param 1: path - the file path.
+* param 2: symbols - a name pool to share with other trees (a private pool is created by default).
+* return value: the tree, with the storage engine it was saved with.
+* throws invalid_argument when the file isn't a valid snapshot and system_error when it can't be read.
+*/
+unique_ptr<Tree> Tree::load(const string &path, shared_ptr<SymbolTable> symbols){
+    MappedFile file(path);
+    const char *data = file.data();
+    const snapshot_header &header = checkSnapshot(data, file.size(), path);
+    snapshot_layout layout = layoutOf(header);
+    const uint64_t *nameRef = reinterpret_cast<const uint64_t*>(data + layout.nameRef);
+    const uint32_t *symbol = reinterpret_cast<const uint32_t*>(data + layout.symbol);
+    const uint32_t *child = reinterpret_cast<const uint32_t*>(data + layout.child);
+    const uint32_t *relationKey = reinterpret_cast<const uint32_t*>(data + layout.relationKey);
+    const uint32_t *firstOf = reinterpret_cast<const uint32_t*>(data + layout.firstOf);
+    auto corrupt = [&path](){
+        return invalid_argument(path + ": corrupt snapshot");
+    };
+
+    if(symbols == NULL){
+        symbols = make_shared<SymbolTable>();
+    }
+    symbols->reserve(symbols->size() + header.names);
+    vector<uint32_t> interned(header.names); // Snapshot symbol -> pool symbol.
+    for(uint32_t s = 0; s < header.names; s++){
+        if(nameRef[s] > nameRef[s + 1] || nameRef[s + 1] > header.blobSize){
+            throw corrupt();
+        }
+        interned[s] = symbols->intern(string_view(data + layout.blob + nameRef[s], nameRef[s + 1] - nameRef[s]));
+    }
+    if(symbol[0] >= header.names || child[0] != SNAPSHOT_NONE){
+        throw corrupt();
+    }
+
+    storage engine = header.engine == (uint32_t)storage::ahnentafel ? storage::ahnentafel : storage::linked;
+    unique_ptr<Tree> T(new Tree(string(symbols->name(interned[symbol[0]])), engine, symbols));
+    T->nodes.reserve(header.people - 1);
+    T->index.reserve(header.names);
+    vector<node*> people(header.people);
+    people[0] = T->root;
+    for(uint32_t i = 1; i < header.people; i++){
+        // Preorder: the child of a person always comes before the person.
+        if(child[i] >= i || symbol[i] >= header.names){
+            throw corrupt();
+        }
+        node *son = people[child[i]];
+        position pos = relationKey[i] & 1 ? mother_pos : father_pos;
+        if((pos == father_pos ? son->father : son->mother) != NULL){
+            throw corrupt();
+        }
+        people[i] = T->attach(son, interned[symbol[i]], pos);
+    }
+    for(uint32_t s = 0; s < header.names; s++){
+        if(firstOf[s] >= header.people || T->firstNamed(interned[s]) != people[firstOf[s]]){
+            throw corrupt();
+        }
+    }
+    return T;
+}
@@ -0,0 +1,56 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace family{
+    /*
+    * The binary snapshot format of Tree::save / Tree::load and MappedTree.
+    * A 64 byte header is followed by sections whose sizes follow from the header, each one 8 byte aligned:
+    *   nameRef      uint64[names + 1]  offset of every name in the blob, the name of i ends where the name of i+1 starts
+    *   buckets      uint32[buckets]    an open addressing hash table of the names by fingerprintOf(name), NONE when empty
+    *   firstOf      uint32[names]      the person a lookup of every name finds (the first one in preorder)
+    *   symbol       uint32[people]     the name of every person, people are in preorder (root first)
+    *   father       uint32[people]     NONE when missing
+    *   mother       uint32[people]     NONE when missing
+    *   child        uint32[people]     NONE for the root
+    *   relationKey  uint32[people]     depth*2 + 1 for mothers, depth*2 for fathers (and 0 for the root)
+    *   blob         char[blobSize]     all names, back to back
+    * The checksum covers everything after the header. Numbers are stored in the byte order of the writing machine,
+    * a file written on a machine of the other byte order is rejected (see byteOrder).
+    */
+    struct snapshot_header {
+        char magic[8];      // SNAPSHOT_MAGIC.
+        uint32_t version;   // SNAPSHOT_VERSION.
+        uint32_t byteOrder; // SNAPSHOT_BYTE_ORDER as written by the saving machine.
+        uint32_t engine;    // The storage engine of the saved tree.
+        uint32_t reserved;
+        uint64_t people;
+        uint64_t names;
+        uint64_t blobSize;
+        uint64_t buckets;   // A power of two, at least twice the number of names.
+        uint64_t checksum;
+    };
+
+    static const char SNAPSHOT_MAGIC[8] = {'F', 'A', 'M', 'T', 'R', 'E', 'E', '\0'};
+    static const uint32_t SNAPSHOT_VERSION = 1;
+    static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+    static const uint32_t SNAPSHOT_NONE = UINT32_MAX;
+
+    /*
+    * snapshot_layout - the file offset of every section, and the total file size.
+    */
+    struct snapshot_layout {
+        size_t nameRef, buckets, firstOf, symbol, father, mother, child, relationKey, blob, size;
+    };
+
+    snapshot_layout layoutOf(const snapshot_header &header);
+    uint64_t checksumOf(const char *data, size_t size);
+    const snapshot_header& checkSnapshot(const char *data, size_t size, const string &path, bool verifyChecksum = true);
+}
@@ -0,0 +1,74 @@
+#include "SymbolTable.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* fingerprintOf - a 32 bit FNV-1a hash of a name. unlike std::hash its value doesn't depend on the platform,
+* so it may be stored in files.
+*/
+uint32_t family::fingerprintOf(string_view name){
+    uint32_t hash = 2166136261u;
+    for(char c : name){
+        hash = (hash ^ (unsigned char)c) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+* intern - get the symbol of a name, adding the name to the table when it is new.
+* param 1: name - the name, moved into the table only when it is new.
+* return value: the symbol id.
+*/
+uint32_t SymbolTable::intern(string &&name){
+    auto entry = ids.find(name);
+    if(entry != ids.end()){
+        return entry->second;
+    }
+    uint32_t symbol = names.size();
+    names.push_back(move(name));
+    ids.emplace(names.back(), symbol);
+    return symbol;
+}
+
+/* Borrowed names are copied only when they are new. */
+uint32_t SymbolTable::intern(string_view name){
+    auto entry = ids.find(name);
+    if(entry != ids.end()){
+        return entry->second;
+    }
+    return intern(string(name));
+}
+
+/*
+* find - get the symbol of a name without adding it.
+* param 1: name - the name.
+* return value: the symbol id Or NONE if the name was never interned.
+*/
+uint32_t SymbolTable::find(string_view name) const{
+    auto entry = ids.find(name);
+    return entry == ids.end() ? NONE : entry->second;
+}
+
+/*
+* reserve - prepares the table for the given number of distinct names.
+*/
+void SymbolTable::reserve(size_t names){
+    ids.reserve(names);
+}
+
+/*
+* name - the name of a symbol.
+* param 1: symbol - a symbol id returned by intern().
+* return value: a view which stays valid as long as the table.
+*/
+string_view SymbolTable::name(uint32_t symbol) const{
+    return names[symbol];
+}
+
+/*
+* size - the number of distinct names.
+*/
+size_t SymbolTable::size() const{
+    return names.size();
+}
@@ -0,0 +1,43 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+using namespace std;
+
+namespace family{
+    uint32_t fingerprintOf(string_view name);
+
+    /*
+    * SymbolTable - an interned name pool. Every distinct name is stored once and identified by a small symbol id,
+    * so nodes hold 4 bytes instead of a string and comparing names is comparing integers.
+    * Symbols are never removed, and one table may be shared by several Tree objects (of the same thread).
+    */
+    class SymbolTable{
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+    private:
+        /*Private variables*/
+        deque<string> names;                    // Symbol id -> name (a deque never moves its strings).
+        unordered_map<string_view, uint32_t> ids; // Name (viewing 'names') -> symbol id.
+
+    public:
+        SymbolTable() = default;
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+        uint32_t intern(string &&name);
+        uint32_t intern(string_view name);
+        uint32_t find(string_view name) const;
+        void reserve(size_t names);
+        string_view name(uint32_t symbol) const;
+        size_t size() const;
+    };
+}
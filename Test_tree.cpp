@@ -0,0 +1,979 @@
+#include "doctest.h"
+#include "FamilyTree.hpp"
+#include "Pedigree.hpp"
+#include "CompactTree.hpp"
+#include "MappedTree.hpp"
+#include "ConcurrentTree.hpp"
+#include "OutputBuffer.hpp"
+#include "WorkerPool.hpp"
+
+using namespace family;
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/* Writes a test file into the temporary directory and returns its path. */
+static string temporaryFile(const string &name, const string &content){
+    string path = (filesystem::temp_directory_path() / name).string();
+    ofstream(path, ios::binary) << content;
+    return path;
+}
+
+TEST_CASE("Node arena reuses released nodes") {
+    NodeArena arena(2);
+    node *a = arena.allocate(0);
+    node *b = arena.allocate(1);
+    node *c = arena.allocate(2); // forces a second chunk
+    CHECK(arena.size() == 3);
+    CHECK(a->symbol == 0);
+    CHECK(c->father == nullptr);
+    CHECK(c->mother == nullptr);
+
+    arena.release(b);
+    CHECK(arena.size() == 2);
+    node *d = arena.allocate(3);
+    CHECK(d == b);
+    CHECK(d->symbol == 3);
+    CHECK(d->father == nullptr);
+}
+
+TEST_CASE("Symbol table interns every name once") {
+    SymbolTable names;
+    uint32_t avraham = names.intern(string_view("Avraham"));
+    CHECK(names.intern(string("Sara")) == avraham + 1);
+    CHECK(names.intern(string("Avraham")) == avraham);
+    CHECK(names.size() == 2);
+    CHECK(names.name(avraham) == "Avraham");
+    CHECK(names.find("Sara") == avraham + 1);
+    CHECK(names.find("Hagar") == SymbolTable::NONE);
+}
+
+TEST_CASE("Trees can share one name pool") {
+    Tree first ("Yosef");
+    Tree second ("Binyamin", storage::linked, first.symbolTable());
+    first.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel");
+    second.addFather("Binyamin", "Yaakov").addMother("Binyamin", "Rachel");
+    CHECK(first.symbolTable() == second.symbolTable());
+    CHECK(first.symbolTable()->size() == 4);
+    CHECK(second.relation("Yosef") == string("unrelated"));
+    CHECK(second.find("mother") == string("Rachel"));
+
+    second.remove("Rachel"); // names outlive the people who use them
+    CHECK(first.find("mother") == string("Rachel"));
+    CHECK(second.relation("Rachel") == string("unrelated"));
+    CHECK(Tree("Efraim").symbolTable() != first.symbolTable());
+}
+
+TEST_CASE("Tree keeps working after removed nodes are recycled") {
+    Tree T ("Yosef");
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addFather("Yaakov", "Isaac").addMother("Yaakov", "Rivka");
+    T.remove("Yaakov");
+    CHECK(T.relation("Isaac") == string("unrelated"));
+    T.addFather("Yosef", "Yehuda").addFather("Yehuda", "Peretz").addMother("Yehuda", "Tamar");
+    CHECK(T.relation("Yehuda") == string("father"));
+    CHECK(T.relation("Tamar") == string("grandmother"));
+    CHECK(T.find("grandfather") == string("Peretz"));
+}
+
+TEST_CASE("Tree with many generations") {
+    Tree T ("p0");
+    for(int i = 0; i < 300; i++){
+        T.addFather("p" + to_string(i), "p" + to_string(i+1));
+    }
+    string expected = "";
+    for(int i = 0; i < 298; i++){
+        expected += "great-";
+    }
+    CHECK(T.relation("p300") == expected + "grandfather");
+    CHECK(T.find(T.relation("p150")) == string("p150"));
+}
+
+TEST_CASE("Name index with repeated names") {
+    Tree T ("Yosef");
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addMother("Rachel", "Ruti").addFather("Yaakov", "Isaac").addMother("Isaac", "Ruti");
+    CHECK(T.relation("Ruti") == string("great-grandmother")); // Isaac's mother comes first in preorder
+    T.addFather("Ruti", "Avi");
+    CHECK(T.relation("Avi") == string("great-great-grandfather"));
+    T.remove("Ruti");  // removes Isaac's mother together with Avi
+    CHECK(T.relation("Avi") == string("unrelated"));
+    CHECK(T.relation("Ruti") == string("grandmother"));
+    T.addFather("Rachel", "Ruti"); // added last, but before Rachel's mother in preorder
+    CHECK(T.relation("Ruti") == string("grandfather"));
+    T.remove("Ruti");
+    T.remove("Ruti");
+    CHECK(T.relation("Ruti") == string("unrelated"));
+    CHECK_THROWS(T.remove("Ruti"));
+}
+
+TEST_CASE("Removing people of a shared name") {
+    // Every leaf of a full pedigree is named after one of 10 names.
+    Tree T ("1");
+    for(int k = 1; k < 4096; k++){
+        string father = 2*k < 4096 ? to_string(2*k) : "leaf" + to_string(2*k % 10);
+        string mother = 2*k + 1 < 4096 ? to_string(2*k + 1) : "leaf" + to_string((2*k + 1) % 10);
+        T.addFather(to_string(k), father).addMother(to_string(k), mother);
+    }
+    CHECK(T.relation("leaf6") == string("great-great-great-great-great-great-great-great-great-great-grandfather")); // 4096
+    T.remove("2048");
+    CHECK(T.relation("leaf6") == string("great-great-great-great-great-great-great-great-great-great-grandfather")); // 4106
+    T.remove("2");
+    size_t wrong = 0;
+    for(int i = 0; i < 10; i++){
+        wrong += T.relation("leaf" + to_string(i)).find("grand") == string::npos;
+    }
+    CHECK(wrong == 0);
+    CHECK(T.relation("leaf4") == string("great-great-great-great-great-great-great-great-great-great-grandfather")); // 6144
+    T.remove("3");
+    CHECK(T.relation("leaf4") == string("unrelated"));
+}
+
+TEST_CASE("Building a large tree through the name index") {
+    Tree T ("1");
+    for(int k = 1; k < 100000; k++){
+        T.addFather(to_string(k), to_string(2*k)).addMother(to_string(k), to_string(2*k+1));
+    }
+    CHECK(T.relation("2") == string("father"));
+    CHECK(T.relation("7") == string("grandmother"));
+    CHECK(T.relation("199999") == string("great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-grandmother"));
+    T.remove("3");
+    CHECK(T.relation("7") == string("unrelated"));
+    CHECK(T.relation("4") == string("grandfather"));
+}
+
+TEST_CASE("Ahnentafel numbering") {
+    CHECK(AhnentafelIndex::fatherOf(1) == 2);
+    CHECK(AhnentafelIndex::motherOf(3) == 7);
+    CHECK(AhnentafelIndex::childOf(7) == 3);
+    relation_data data = AhnentafelIndex::relationOf(13);
+    CHECK(data.valid);
+    CHECK(data.depth == 3);
+    CHECK(data.pos == mother_pos);
+    CHECK(AhnentafelIndex::relationOf(1).pos == self);
+}
+
+TEST_CASE("Ahnentafel storage engine") {
+    Tree T ("Yosef", storage::ahnentafel);
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addFather("Yaakov", "Isaac").addMother("Yaakov", "Rivka")
+     .addFather("Rachel", "Avi").addMother("Rachel", "Ruti")
+     .addFather("Avi", "Israel").addMother("Isaac", "Sara");
+    CHECK(T.find("me") == string("Yosef"));
+    CHECK(T.find("father") == string("Yaakov"));
+    CHECK(T.find("mother") == string("Rachel"));
+    CHECK(T.find("grandfather") == string("Isaac"));  // first in preorder
+    CHECK(T.find("grandmother") == string("Rivka"));
+    CHECK(T.find("great-grandmother") == string("Sara"));
+    CHECK(T.find("great-grandfather") == string("Israel"));
+    CHECK_THROWS(T.find("great-great-grandfather"));
+    CHECK(T.relation("Israel") == string("great-grandfather"));
+
+    T.remove("Isaac");
+    CHECK(T.find("grandfather") == string("Avi"));
+    CHECK_THROWS(T.find("great-grandmother"));
+    T.remove("Rachel");
+    CHECK_THROWS(T.find("great-grandfather"));
+    CHECK_THROWS(T.find("grandfather"));
+    CHECK_THROWS(T.remove("Yosef"));
+    T.addMother("Yosef", "Lea").addMother("Lea", "Dina");
+    CHECK(T.find("grandmother") == string("Rivka"));
+    T.remove("Rivka");
+    CHECK(T.find("grandmother") == string("Dina"));
+}
+
+TEST_CASE("Ahnentafel storage engine beyond numbered generations") {
+    Tree T ("p0", storage::ahnentafel);
+    for(int i = 0; i < 100; i++){
+        T.addMother("p" + to_string(i), "p" + to_string(i+1));
+    }
+    string greats = "";
+    for(int i = 0; i < 78; i++){
+        greats += "great-";
+    }
+    CHECK(T.find(greats + "grandmother") == string("p80"));
+    CHECK(T.find("great-great-grandmother") == string("p4"));
+    T.remove("p70");
+    CHECK_THROWS(T.find(greats + "grandmother"));
+    CHECK(T.find(T.relation("p69")) == string("p69"));
+}
+
+TEST_CASE("Pruning many branches through child links") {
+    Tree T ("1");
+    for(int k = 1; k < 32768; k++){
+        T.addFather(to_string(k), to_string(2*k)).addMother(to_string(k), to_string(2*k+1));
+    }
+    for(int k = 4096; k < 8192; k++){
+        T.remove(to_string(2*k+1)); // every mother of generation 13
+    }
+    CHECK(T.relation("8193") == string("unrelated"));
+    CHECK(T.relation("16386") == string("unrelated"));
+    CHECK(T.relation("8192") == string("great-great-great-great-great-great-great-great-great-great-great-grandfather"));
+    T.addMother("4096", "Sara");
+    CHECK(T.relation("Sara") == string("great-great-great-great-great-great-great-great-great-great-great-grandmother"));
+    T.remove("2");
+    T.remove("3");
+    CHECK(T.relation("Sara") == string("unrelated"));
+    CHECK(T.find("me") == string("1"));
+    CHECK_THROWS(T.find("father"));
+}
+
+TEST_CASE("Removed branches are reclaimed in slices") {
+    for(storage engine : {storage::linked, storage::ahnentafel}){
+        Tree T ("1", engine);
+        for(int k = 1; k < 8192; k++){
+            T.addFather(to_string(k), to_string(2*k)).addMother(to_string(k), to_string(2*k+1));
+        }
+        T.remove("2"); // 8191 people, left in the indexes for later changes
+        CHECK(T.relation("2") == string("unrelated"));
+        CHECK(T.relation("12287") == string("unrelated"));
+        CHECK(T.relation("12288") == string("great-great-great-great-great-great-great-great-great-great-great-grandfather"));
+        CHECK(T.tryFind("father").code == status::relation_not_found);
+        CHECK(T.find("grandfather") == string("6"));
+        CHECK(T.tryRemove("4") == status::person_not_found);
+        CHECK(T.tryAddMother("4", "Sara") == status::person_not_found);
+
+        // The removed names and places can be taken again right away.
+        T.addFather("1", "2").addFather("2", "4");
+        CHECK(T.relation("4") == string("grandfather"));
+        CHECK(T.find("grandfather") == string("4"));
+        CHECK(T.relation("8") == string("unrelated"));
+        string path = temporaryFile("reclaim.snapshot", "");
+        T.save(path);
+        CHECK(Tree::load(path)->relation("4") == string("grandfather"));
+        filesystem::remove(path);
+
+        for(int i = 0; i < 10; i++){
+            T.addMother("2", "m" + to_string(i)).remove("m" + to_string(i));
+        }
+        CHECK(T.find("great-grandfather") == string("12"));
+        CHECK(T.relation("9") == string("unrelated"));
+        ostringstream shown;
+        T.display(shown);
+        size_t lines = 0;
+        for(char c : shown.str()){
+            lines += c == '\n';
+        }
+        CHECK(lines == 1 + 8191 + 2);
+
+        // A read only workload reclaims its removed people at once instead.
+        T.remove("3");
+        CHECK_FALSE(T.compact(1));
+        CHECK(T.compact());
+        CHECK(T.relation("12") == string("unrelated"));
+        CHECK(T.relation("4") == string("grandfather"));
+        CHECK(T.tryFind("mother").code == status::relation_not_found);
+    }
+}
+
+TEST_CASE("Relation parser") {
+    CHECK(parseRelation("me").depth == 0);
+    CHECK(parseRelation("father").pos == father_pos);
+    CHECK(parseRelation("mother").depth == 1);
+    CHECK(parseRelation("grandmother").depth == 2);
+    relation_data data = parseRelation("great-great-great-grandfather");
+    CHECK(data.valid);
+    CHECK(data.depth == 5);
+    CHECK(data.pos == father_pos);
+
+    CHECK_FALSE(parseRelation("").valid);
+    CHECK_FALSE(parseRelation("great").valid);
+    CHECK_FALSE(parseRelation("great-").valid);
+    CHECK_FALSE(parseRelation("great-father").valid);
+    CHECK_FALSE(parseRelation("great-me").valid);
+    CHECK_FALSE(parseRelation("grandfather-").valid);
+    CHECK_FALSE(parseRelation("-grandfather").valid);
+    CHECK_FALSE(parseRelation("great--grandfather").valid);
+    CHECK_FALSE(parseRelation("Grandfather").valid);
+    CHECK_FALSE(parseRelation("grandfathers").valid);
+}
+
+TEST_CASE("Relation strings") {
+    relation_data data = parseRelation("great-great-grandmother");
+    CHECK(relationToString(data) == string("great-great-grandmother"));
+    data.depth = 100;
+    string deep = relationToString(data);
+    CHECK(deep.size() == 98 * 6 + 11);
+    CHECK(parseRelation(deep).depth == 100);
+    data.valid = false;
+    CHECK(relationToString(data) == string("unrelated"));
+
+    Tree T ("Yosef");
+    T.addFather("Yosef", "Yaakov").addFather("Yaakov", "Isaac").addFather("Isaac", "Avraham");
+    char buffer[32];
+    CHECK(T.relation("Avraham", buffer, sizeof(buffer)) == 17);
+    CHECK(string(buffer) == string("great-grandfather"));
+    CHECK(T.relation("Yosef", buffer, sizeof(buffer)) == 2);
+    CHECK(string(buffer) == string("me"));
+    CHECK(T.relation("Lavan", buffer, sizeof(buffer)) == 9);
+    CHECK(string(buffer) == string("unrelated"));
+    CHECK(T.relation("Avraham", buffer, 6) == 17);  // truncated
+    CHECK(string(buffer) == string("great"));
+}
+
+TEST_CASE("string_view and moved names") {
+    string root = "Yosef";
+    Tree T (root);
+    string_view father = "Yaakov-the-son-of-Isaac";
+    string mother = "Rachel-the-daughter-of-Lavan";
+    T.addFather(root, father).addMother(string_view(root), move(mother));
+    string grandfather = "Isaac";
+    T.addFather(father, grandfather);
+    CHECK(grandfather == string("Isaac"));
+    CHECK(T.relation(father) == string("father"));
+    CHECK(T.relation(string_view("Rachel-the-daughter-of-Lavan")) == string("mother"));
+    CHECK(T.relation(string_view("Isaac-and-more").substr(0, 5)) == string("grandfather"));
+    CHECK(T.find(string_view("grandfather-of-Yosef").substr(0, 11)) == string("Isaac"));
+    T.remove(string_view("Isaac"));
+    CHECK(T.relation("Isaac") == string("unrelated"));
+}
+
+TEST_CASE("Non throwing try API") {
+    Tree T ("Yosef");
+    CHECK(T.tryAddFather("Yosef", "Yaakov") == status::ok);
+    CHECK(T.tryAddMother("Yosef", string("Rachel")) == status::ok);
+    CHECK(T.tryAddFather("Yosef", "Lavan") == status::already_exist);
+    CHECK(T.tryAddMother("Yosef", string_view("Lea")) == status::already_exist);
+    CHECK(T.tryAddFather("Lavan", "Betuel") == status::person_not_found);
+    CHECK(T.tryAddMother("Yaakov", "Rivka") == status::ok);
+    CHECK(T.relation("Lavan") == string("unrelated"));
+
+    find_result found = T.tryFind("grandmother");
+    CHECK(found);
+    CHECK(found.code == status::ok);
+    CHECK(found.name == "Rivka");
+    CHECK(T.tryFind("grandfather").code == status::relation_not_found);
+    CHECK_FALSE(T.tryFind("grandfather"));
+    CHECK(T.tryFind("great-").code == status::bad_relation);
+
+    CHECK(T.tryRemove("Lavan") == status::person_not_found);
+    CHECK(T.tryRemove("Yosef") == status::delete_root);
+    CHECK(T.tryRemove("Yaakov") == status::ok);
+    CHECK(T.tryFind("grandmother").code == status::relation_not_found);
+
+    CHECK_THROWS(T.remove("Yosef"));
+    CHECK_THROWS(T.remove("Yaakov"));
+    CHECK_THROWS(T.addMother("Yosef", "Lea"));
+}
+
+TEST_CASE("Batch queries") {
+    for(storage engine : {storage::linked, storage::ahnentafel}){
+        Tree T ("Yosef", engine);
+        T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+         .addFather("Yaakov", "Isaac").addMother("Yaakov", "Rivka")
+         .addFather("Rachel", "Avi").addMother("Rachel", "Ruti");
+        vector<string_view> names = {"Ruti", "Lavan", "Yosef", "Isaac", "Ruti"};
+        vector<string> relations = T.relations(names);
+        CHECK(relations == vector<string>{"grandmother", "unrelated", "me", "grandfather", "grandmother"});
+
+        vector<string_view> asked = {"grandmother", "me", "great-grandfather", "grand", "mother", "grandmother"};
+        vector<find_result> found = T.findAll(asked);
+        REQUIRE(found.size() == asked.size());
+        CHECK(found[0].name == "Rivka");
+        CHECK(found[1].name == "Yosef");
+        CHECK(found[2].code == status::relation_not_found);
+        CHECK(found[3].code == status::bad_relation);
+        CHECK(found[4].name == "Rachel");
+        CHECK(found[5].name == "Rivka");
+        CHECK(T.findAll(vector<string_view>{"grand"}).at(0).code == status::bad_relation);
+        CHECK(T.findAll(vector<string_view>{}).empty());
+    }
+
+    pedigree sparse = sparsePedigree(3000, 17);
+    Tree S (sparse.root);
+    replay(sparse, S);
+    vector<string> relationNames;
+    for(int depth = 0; depth < 30; depth++){
+        for(position pos : {father_pos, mother_pos}){
+            relationNames.push_back(relationToString({true, depth, depth == 0 ? self : pos}));
+        }
+    }
+    vector<string_view> asked(relationNames.rbegin(), relationNames.rend());
+    vector<find_result> found = S.findAll(asked);
+    size_t mismatches = 0;
+    for(size_t i = 0; i < asked.size(); i++){
+        find_result one = S.tryFind(asked[i]);
+        mismatches += one.code != found[i].code || one.name != found[i].name;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("Concurrent readers and writers") {
+    ConcurrentTree T ("g0");
+    for(int i = 0; i < 100; i++){
+        T.addFather("g" + to_string(i), "g" + to_string(i + 1));
+    }
+    vector<size_t> wrong(4, 0);
+    vector<thread> readers;
+    for(size_t r = 0; r < wrong.size(); r++){
+        readers.emplace_back([&T, &wrong, r](){
+            char buffer[1024];
+            for(int round = 0; round < 2000; round++){
+                int i = round % 100;
+                string expected = T.relation("g" + to_string(i));
+                wrong[r] += T.relation("g" + to_string(i), buffer, sizeof(buffer)) != expected.size();
+                string found = string(T.tryFind("grandfather").name);
+                wrong[r] += found != "g2";
+                string mother = T.relation("m" + to_string(i));
+                wrong[r] += mother != "unrelated" && mother != "mother";
+            }
+        });
+    }
+    size_t duplicates = 0;
+    for(int round = 0; round < 200; round++){
+        int i = round % 100;
+        T.addMother("g0", "m" + to_string(i));
+        duplicates += T.tryAddMother("g0", "x") == status::already_exist;
+        T.remove("m" + to_string(i));
+    }
+    CHECK(duplicates == 200);
+    for(thread &reader : readers){
+        reader.join();
+    }
+    size_t mistakes = 0;
+    for(size_t w : wrong){
+        mistakes += w;
+    }
+    CHECK(mistakes == 0);
+    CHECK(T.find("great-grandfather") == string("g3"));
+    CHECK(T.tryRemove("g0") == status::delete_root);
+}
+
+TEST_CASE("Epoch based reclamation of removed branches") {
+    ConcurrentTree T ("g0", storage::linked, reclamation::epoch);
+    for(int i = 0; i < 50; i++){
+        T.addFather("g" + to_string(i), "g" + to_string(i + 1));
+    }
+    vector<size_t> wrong(3, 0);
+    vector<thread> readers;
+    for(size_t r = 0; r < wrong.size(); r++){
+        readers.emplace_back([&T, &wrong, r](){
+            for(int round = 0; round < 3000; round++){
+                find_result father = T.tryFind("father");
+                wrong[r] += father.name != "g1";
+                find_result mother = T.tryFind("great-grandmother");
+                wrong[r] += mother.code == status::ok && mother.name.substr(0, 1) != "m";
+                string relation = T.relation("g" + to_string(round % 50));
+                wrong[r] += relation == "unrelated";
+            }
+        });
+    }
+    atomic<bool> removing(true);
+    thread reclaimer([&T, &removing](){
+        while(removing){
+            T.compact();
+        }
+    });
+    size_t failures = 0;
+    for(int round = 0; round < 100; round++){
+        string m = "m" + to_string(round);
+        failures += T.tryAddMother("g2", m) != status::ok;
+        for(int i = 0; i < 20; i++){
+            failures += T.tryAddMother(m + (i == 0 ? "" : "-" + to_string(i - 1)), m + "-" + to_string(i)) != status::ok;
+        }
+        failures += T.tryRemove(m) != status::ok;
+        failures += T.tryRemove(m + "-5") != status::person_not_found;
+    }
+    removing = false;
+    reclaimer.join();
+    for(thread &reader : readers){
+        reader.join();
+    }
+    size_t mistakes = 0;
+    for(size_t w : wrong){
+        mistakes += w;
+    }
+    CHECK(failures == 0);
+    CHECK(mistakes == 0);
+    CHECK(T.tryFind("great-grandmother").code == status::relation_not_found);
+    CHECK(T.relation("m99-3") == string("unrelated"));
+    CHECK(T.tryRemove("g0") == status::delete_root);
+    T.addMother("g2", "Rivka");
+    CHECK(T.find("great-grandmother") == string("Rivka"));
+    T.remove("g10");
+    T.compact();
+    CHECK(T.relation("g30") == string("unrelated"));
+    CHECK(T.relation("g9").substr(0, 6) == "great-");
+}
+
+TEST_CASE("Concurrent insertion of parents") {
+    ConcurrentTree T ("Yosef", storage::linked, reclamation::epoch, insertion::concurrent);
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel");
+    T.addFather("Yaakov", "s0").addMother("Yaakov", "s1").addFather("Rachel", "s2").addMother("Rachel", "s3");
+    const int people = 500;
+    vector<size_t> failures(4, 0), won(4, 0);
+    vector<thread> ingest;
+    for(size_t t = 0; t < failures.size(); t++){
+        ingest.emplace_back([&T, &failures, &won, t](){
+            // A full pedigree of 'people' above s<t>, named s<t>-<ahnentafel number>.
+            string prefix = "s" + to_string(t);
+            for(int k = 1; 2*k + 1 <= people; k++){
+                string child = k == 1 ? prefix : prefix + "-" + to_string(k);
+                failures[t] += T.tryAddFather(child, prefix + "-" + to_string(2*k)) != status::ok;
+                failures[t] += T.tryAddMother(child, prefix + "-" + to_string(2*k + 1)) != status::ok;
+                failures[t] += T.tryAddFather(child, "late") != status::already_exist;
+                if(k % 50 == 0){
+                    // Every thread races for the same empty slot of a leaf, at most one wins.
+                    status code = T.tryAddFather("s" + to_string(k / 50 % 4) + "-" + to_string(250 + k), "racer");
+                    won[t] += code == status::ok;
+                    failures[t] += code != status::ok && code != status::already_exist && code != status::person_not_found;
+                }
+            }
+        });
+    }
+    size_t mistakes = 0;
+    for(int round = 0; round < 2000; round++){
+        mistakes += T.relation("s1") != string("grandmother");
+        mistakes += T.tryFind("mother").name != "Rachel";
+        if(round % 200 == 0){
+            // Walk the whole tree while parents are being linked.
+            ostringstream partial;
+            T.display(partial);
+            string_view wanted[] = {"grandmother", "great-grandfather"};
+            vector<find_result> found = T.findAll(wanted);
+            mistakes += found[0].name != "s1" || partial.str().rfind("Yosef\n", 0) != 0;
+        }
+    }
+    for(thread &thread : ingest){
+        thread.join();
+    }
+    size_t total = 0, wins = 0;
+    for(size_t t = 0; t < failures.size(); t++){
+        total += failures[t];
+        wins += won[t];
+    }
+    CHECK(total == 0);
+    CHECK(mistakes == 0);
+    CHECK(T.relation("s3-2") == string("great-grandfather"));
+    CHECK(T.relation("s1-499") == string("great-great-great-great-great-great-great-great-grandmother"));
+    CHECK(T.tryAddMother("s2-7", "twice") == status::already_exist);
+    CHECK(T.tryAddFather("nobody", "orphan") == status::person_not_found);
+    T.remove("s0-2");
+    CHECK(T.relation("s0-4") == string("unrelated"));
+    CHECK(T.relation("s0-3") == string("great-grandmother"));
+
+    ostringstream shown;
+    T.display(shown);
+    size_t lines = 0;
+    for(char c : shown.str()){
+        lines += c == '\n';
+    }
+    size_t racers = 0;
+    for(size_t at = shown.str().find("father: racer"); at != string::npos; at = shown.str().find("father: racer", at + 1)){
+        racers++;
+    }
+    // Yosef, his parents and grandparents, the 4 pedigrees without the 255 people of s0-2's branch, and the racers.
+    CHECK(lines == 7 + 4 * (people - 2) - 255 + wins);
+    CHECK(racers == wins);
+}
+
+TEST_CASE("Parallel search by relation finds the same person") {
+    // A random tree, large enough to be searched in parallel.
+    Tree T ("r0");
+    mt19937 random(2020);
+    int people = 1;
+    while(people < 80000){
+        string child = "r" + to_string(random() % people);
+        string parent = "r" + to_string(people);
+        status code = random() % 2 ? T.tryAddFather(child, parent) : T.tryAddMother(child, parent);
+        people += code == status::ok;
+    }
+    relation_data data;
+    data.valid = true;
+    size_t differences = 0, found = 0;
+    for(data.depth = 0; data.depth < 40; data.depth++){
+        for(position pos : {father_pos, mother_pos}){
+            data.pos = data.depth == 0 ? self : pos;
+            string relation = relationToString(data);
+            find_result sequential = T.tryFind(relation);
+            for(size_t threads : {2, 4, 7, 0}){
+                find_result parallel = T.tryFind(relation, threads);
+                differences += parallel.code != sequential.code || parallel.name != sequential.name;
+            }
+            found += sequential.code == status::ok;
+        }
+    }
+    CHECK(differences == 0);
+    CHECK(found > 20);
+    CHECK(found < 80);
+    CHECK(T.tryFind("grandson", 4).code == status::bad_relation);
+}
+
+TEST_CASE("Worker pool runs every task once") {
+    WorkerPool pool;
+    vector<size_t> counts(4, 0);
+    vector<thread> callers;
+    for(size_t c = 0; c < counts.size(); c++){
+        callers.emplace_back([&pool, &counts, c](){
+            for(int round = 0; round < 50; round++){
+                atomic<size_t> next(0), done(0);
+                pool.run(c + 1, [&next, &done](){
+                    while(next++ < 100){
+                        done++;
+                    }
+                });
+                counts[c] += done;
+            }
+        });
+    }
+    for(thread &caller : callers){
+        caller.join();
+    }
+    CHECK(counts == vector<size_t>(4, 5000)); // Busy pools run the job on the caller alone.
+    atomic<size_t> ran(0);
+    pool.run(0, [&ran](){ ran++; });
+    CHECK(ran == 1);
+}
+
+TEST_CASE("Deep lineages don't need recursion") {
+    const int generations = 200000;
+    Tree T ("g0");
+    for(int i = 0; i < generations; i++){
+        T.addMother("g" + to_string(i), "g" + to_string(i+1));
+    }
+    T.addFather("g" + to_string(generations - 1), "last-father");
+    string greats = "";
+    for(int i = 0; i < generations - 2; i++){
+        greats += "great-";
+    }
+    CHECK(T.find(greats + "grandmother") == string("g200000"));
+    CHECK(T.find(greats + "grandfather") == string("last-father"));
+    CHECK(T.relation("g200000") == greats + "grandmother");
+
+    std::streambuf *original = cout.rdbuf();
+    ostringstream output;
+    cout.rdbuf(output.rdbuf());
+    T.display();
+    cout.rdbuf(original);
+    CHECK(output.str().find("g199999's father: last-father\n") != string::npos);
+
+    T.remove("g100000");
+    CHECK(T.relation("g100001") == string("unrelated"));
+    CHECK_THROWS(T.find(greats + "grandfather"));
+    T.remove("g1");
+    CHECK_THROWS(T.find("mother"));
+}
+
+TEST_CASE("Generated pedigrees") {
+    pedigree full = fullPedigree(4);
+    CHECK(full.operations.size() == 30);
+    Tree F (full.root);
+    replay(full, F);
+    CHECK(F.relation("p31") == string("great-great-grandmother"));
+    CHECK(F.find("great-grandfather") == string("p8"));
+    CHECK_THROWS_AS(fullPedigree(AhnentafelIndex::MAX_DEPTH + 1), invalid_argument);
+    CHECK_THROWS_AS(fullPedigree(-1), invalid_argument);
+
+    pedigree chain = chainPedigree(10, mother_pos);
+    Tree C (chain.root);
+    replay(chain, C);
+    CHECK(C.relation("g10") == string("great-great-great-great-great-great-great-great-grandmother"));
+
+    pedigree sparse = sparsePedigree(500, 7);
+    CHECK(sparse.operations.size() == 499);
+    CHECK(sparsePedigree(500, 7).operations.back().name == sparse.operations.back().name);
+    CHECK(sparsePedigree(500, 8).operations.back().to != sparse.operations.back().to);
+    Tree S (sparse.root);
+    replay(sparse, S);
+    size_t unrelated = 0;
+    for(const operation &op : sparse.operations){
+        unrelated += S.relation(op.name) == string("unrelated");
+    }
+    CHECK(unrelated == 0);
+
+    pedigree collapsed = collapsedPedigree(2000, 0.4, 3);
+    CHECK(collapsed.operations.size() == 1999);
+    Tree R (collapsed.root);
+    CHECK_NOTHROW(replay(collapsed, R));
+    size_t repeated = 0;
+    for(const operation &op : collapsed.operations){
+        repeated += op.name.compare(1, string::npos, to_string(&op - &collapsed.operations.front() + 1)) != 0;
+    }
+    CHECK(repeated > 600);
+    CHECK(repeated < 1000);
+
+    stringstream script;
+    writeScript(collapsed, script);
+    pedigree reread = readScript(script);
+    CHECK(reread.root == collapsed.root);
+    CHECK(reread.operations.size() == collapsed.operations.size());
+    CHECK(reread.operations.at(1000).name == collapsed.operations.at(1000).name);
+    CHECK(reread.operations.at(1000).pos == collapsed.operations.at(1000).pos);
+}
+
+TEST_CASE("Loading a tree from an edge list") {
+    string path = temporaryFile("family_tree_test.csv",
+        "child,father,mother\n"
+        "Rachel,Avi,\r\n"
+        "Yosef,Yaakov,Rachel\n"
+        "\n"
+        "Yaakov,Isaac,Rivka\n"
+        "Rachel,,Ruti\n"
+        "Isaac,,\n");
+    unique_ptr<Tree> T = Tree::loadCsv(path);
+    CHECK(T->find("me") == string("Yosef"));
+    CHECK(T->relation("Avi") == string("grandfather"));
+    CHECK(T->relation("Ruti") == string("grandmother"));
+    CHECK(T->find("grandmother") == string("Rivka"));
+    CHECK(T->symbolTable()->size() == 7);
+    T->addFather("Isaac", "Avraham");
+    CHECK(T->relation("Avraham") == string("great-grandfather"));
+
+    pedigree sparse = sparsePedigree(3000, 5);
+    Tree S (sparse.root);
+    replay(sparse, S);
+    stringstream csv;
+    writeCsv(sparse, csv);
+    unique_ptr<Tree> L = Tree::loadCsv(temporaryFile("family_tree_test.csv", csv.str()), storage::ahnentafel);
+    size_t mismatches = 0;
+    for(const operation &op : sparse.operations){
+        mismatches += L->relation(op.name) != S.relation(op.name);
+    }
+    CHECK(mismatches == 0);
+
+    CHECK_THROWS_AS(Tree::loadCsv(temporaryFile("family_tree_test.csv", "Yosef,Yaakov\nYosef,Isaac\n")), invalid_argument);
+    CHECK_THROWS_AS(Tree::loadCsv(temporaryFile("family_tree_test.csv", "Yosef,Yaakov\nBinyamin,Yaakov\n")), invalid_argument);
+    CHECK_THROWS_AS(Tree::loadCsv(temporaryFile("family_tree_test.csv", "Yosef,Yaakov\nEfraim,Yosef\nYaakov,Efraim\n")), invalid_argument);
+    CHECK_THROWS_AS(Tree::loadCsv(temporaryFile("family_tree_test.csv", "Yosef,Yaakov,Rachel,Bilha\n")), invalid_argument);
+    CHECK_THROWS_AS(Tree::loadCsv(temporaryFile("family_tree_test.csv", "")), invalid_argument);
+    CHECK_THROWS(Tree::loadCsv(path + ".missing"));
+    filesystem::remove(path);
+}
+
+TEST_CASE("Binary snapshots") {
+    Tree T ("Yosef", storage::ahnentafel);
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addFather("Yaakov", "Isaac").addMother("Yaakov", "Rivka")
+     .addFather("Rachel", "Avi").addMother("Rachel", "Ruti")
+     .addFather("Avi", "Lavan").addMother("Avi", "Ruti");
+    T.remove("Isaac");
+    string path = (filesystem::temp_directory_path() / "family_tree_test.snapshot").string();
+    T.save(path);
+    unique_ptr<Tree> L = Tree::load(path);
+    CHECK(L->find("me") == string("Yosef"));
+    CHECK(L->find("great-grandfather") == string("Lavan"));
+    CHECK(L->relation("Ruti") == string("great-grandmother")); // Avi's mother, the first Ruti in preorder
+    CHECK(L->relation("Isaac") == string("unrelated"));
+    CHECK(L->symbolTable()->size() == 7);
+    CHECK(L->tryAddFather("Yaakov", "Avraham") == status::ok);
+    CHECK(L->find("grandfather") == string("Avraham"));
+
+    pedigree sparse = sparsePedigree(3000, 9);
+    Tree S (sparse.root);
+    replay(sparse, S);
+    S.save(path);
+    unique_ptr<Tree> R = Tree::load(path, T.symbolTable());
+    CHECK(R->symbolTable() == T.symbolTable());
+    size_t mismatches = 0;
+    for(const operation &op : sparse.operations){
+        mismatches += R->relation(op.name) != S.relation(op.name);
+    }
+    for(int depth = 0; depth < 30; depth++){
+        for(position pos : {father_pos, mother_pos}){
+            string relation = relationToString({true, depth, depth == 0 ? self : pos});
+            mismatches += R->tryFind(relation).name != S.tryFind(relation).name;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    ifstream in(path, ios::binary);
+    string image((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    image[image.size() / 2] ^= 1;
+    CHECK_THROWS_AS(Tree::load(temporaryFile("family_tree_test.snapshot", image)), invalid_argument);
+    CHECK_THROWS_AS(Tree::load(temporaryFile("family_tree_test.snapshot", image.substr(0, 100))), invalid_argument);
+    CHECK_THROWS_AS(Tree::load(temporaryFile("family_tree_test.snapshot", "Yosef,Yaakov,Rachel\n")), invalid_argument);
+    filesystem::remove(path);
+}
+
+TEST_CASE("Read only trees mapped from snapshots") {
+    Tree T ("Yosef");
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addFather("Yaakov", "Isaac").addMother("Yaakov", "Rivka")
+     .addFather("Rachel", "Avi").addMother("Rachel", "Ruti")
+     .addFather("Avi", "Lavan").addMother("Avi", "Ruti");
+    string path = (filesystem::temp_directory_path() / "family_tree_test.snapshot").string();
+    T.save(path);
+    MappedTree M (path, true);
+    CHECK(M.size() == 9);
+    CHECK(M.nameOf(0) == "Yosef");
+    CHECK(M.nameOf(M.motherOf(M.fatherOf(0))) == "Rivka");
+    CHECK(M.childOf(0) == MappedTree::NONE);
+    CHECK(M.nameOf(M.childOf(M.search("Lavan"))) == "Avi");
+    CHECK(M.search("Lea") == MappedTree::NONE);
+    CHECK(M.relation("Ruti") == string("great-grandmother")); // the first Ruti in preorder, as Tree finds
+    CHECK(M.relation("Lea") == string("unrelated"));
+    CHECK(M.find("great-grandfather") == string("Lavan"));
+    CHECK(M.tryFind("great-great-grandmother").code == status::relation_not_found);
+    CHECK(M.tryFind("grand").code == status::bad_relation);
+
+    pedigree sparse = sparsePedigree(3000, 13);
+    Tree S (sparse.root);
+    replay(sparse, S);
+    S.save(path);
+    MappedTree first (path);
+    MappedTree second (path);
+    size_t mismatches = 0;
+    for(const operation &op : sparse.operations){
+        mismatches += first.relation(op.name) != S.relation(op.name);
+        mismatches += second.relation(op.name) != S.relation(op.name);
+    }
+    for(int depth = 0; depth < 30; depth++){
+        for(position pos : {father_pos, mother_pos}){
+            string relation = relationToString({true, depth, depth == 0 ? self : pos});
+            mismatches += first.tryFind(relation).name != S.tryFind(relation).name;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    ifstream in(path, ios::binary);
+    string image((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    image[image.size() - 1] ^= 1;
+    string corrupt = temporaryFile("family_tree_test.corrupt", image);
+    CHECK_NOTHROW(MappedTree(corrupt, false));
+    CHECK_THROWS_AS(MappedTree(corrupt, true), invalid_argument);
+
+    T.save(path); // Corrupt tables are detected when they are used, even without the checksum.
+    ifstream small(path, ios::binary);
+    string clean((istreambuf_iterator<char>(small)), istreambuf_iterator<char>());
+    snapshot_header header;
+    memcpy(&header, clean.data(), sizeof(header));
+    snapshot_layout layout = layoutOf(header);
+    auto corrupted = [&](size_t offset, size_t count, uint32_t value){
+        string damaged = clean;
+        for(size_t i = 0; i < count; i++){
+            memcpy(&damaged[offset + i * sizeof(uint32_t)], &value, sizeof(uint32_t));
+        }
+        return temporaryFile("family_tree_test.corrupt", damaged);
+    };
+    CHECK_THROWS_AS(MappedTree(corrupted(layout.buckets, header.buckets, 0), false).search("Lea"), invalid_argument);
+    CHECK_THROWS_AS(MappedTree(corrupted(layout.buckets, header.buckets, 1000), false).search("Yosef"), invalid_argument);
+    CHECK_THROWS_AS(MappedTree(corrupted(layout.firstOf, header.names, 1000), false).search("Yosef"), invalid_argument);
+    CHECK_THROWS_AS(MappedTree(corrupted(layout.symbol, 1, 1000), false).nameOf(0), invalid_argument);
+    CHECK_THROWS_AS(MappedTree(corrupted(layout.nameRef + sizeof(uint64_t), 2, UINT32_MAX), false).relation("Yosef"), invalid_argument);
+    filesystem::remove(corrupt);
+    filesystem::remove(path);
+}
+
+TEST_CASE("Buffered display and streaming exporters") {
+    Tree T ("Yosef");
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addFather("Yaakov", "Isaac").addMother("Rachel", "Ruti \"the\\ Moabite\"");
+    stringstream lines;
+    T.display(lines);
+    CHECK(lines.str() == "Yosef\nYosef's father: Yaakov\nYaakov's father: Isaac\nYosef's mother: Rachel\n"
+                         "Rachel's mother: Ruti \"the\\ Moabite\"\n");
+
+    stringstream dot;
+    T.exportDot(dot);
+    CHECK(dot.str() == "digraph family {\n"
+                       "  0 [label=\"Yosef\"];\n"
+                       "  1 [label=\"Yaakov\"];\n  1 -> 0 [label=father];\n"
+                       "  2 [label=\"Isaac\"];\n  2 -> 1 [label=father];\n"
+                       "  3 [label=\"Rachel\"];\n  3 -> 0 [label=mother];\n"
+                       "  4 [label=\"Ruti \\\"the\\\\ Moabite\\\"\"];\n  4 -> 3 [label=mother];\n"
+                       "}\n");
+
+    stringstream json;
+    T.exportJsonLines(json);
+    string first, last, line;
+    getline(json, first);
+    while(getline(json, line)){
+        last = line;
+    }
+    CHECK(first == "{\"id\": 0, \"name\": \"Yosef\", \"child\": null, \"relation\": \"me\"}");
+    CHECK(last == "{\"id\": 4, \"name\": \"Ruti \\\"the\\\\ Moabite\\\"\", \"child\": 3, \"relation\": \"grandmother\"}");
+
+    Tree C ("Lea\nBat\tLavan"); // DOT has no escapes for control characters other than the line break.
+    stringstream controlDot, controlJson;
+    C.exportDot(controlDot);
+    C.exportJsonLines(controlJson);
+    CHECK(controlDot.str() == "digraph family {\n  0 [label=\"Lea\\nBat Lavan\"];\n}\n");
+    CHECK(controlJson.str() == "{\"id\": 0, \"name\": \"Lea\\u000aBat\\u0009Lavan\", \"child\": null, \"relation\": \"me\"}\n");
+
+    pedigree sparse = sparsePedigree(20000, 3); // more text than one output buffer
+    Tree S (sparse.root);
+    replay(sparse, S);
+    stringstream linked, compact;
+    S.display(linked);
+    CompactTree(S).display(compact);
+    CHECK(linked.str().size() > OutputBuffer::SIZE);
+    CHECK(linked.str() == compact.str());
+}
+
+TEST_CASE("Compact structure-of-arrays copy") {
+    Tree T ("Yosef");
+    T.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel")
+     .addFather("Yaakov", "Isaac").addMother("Yaakov", "Rivka")
+     .addFather("Rachel", "Avi").addMother("Rachel", "Ruti")
+     .addFather("Avi", "Israel").addMother("Isaac", "Sara");
+    CompactTree C (T);
+    CHECK(C.size() == 9);
+    CHECK(C.nameOf(0) == "Yosef");
+    CHECK(C.nameOf(C.fatherOf(0)) == "Yaakov");
+    CHECK(C.nameOf(C.motherOf(C.fatherOf(0))) == "Rivka");
+    CHECK(C.childOf(0) == CompactTree::NONE);
+    CHECK(C.nameOf(C.childOf(C.search("Israel"))) == "Avi");
+    CHECK(C.search("Lavan") == CompactTree::NONE);
+    CHECK(C.relation("Sara") == string("great-grandmother"));
+    CHECK(C.relation("Lavan") == string("unrelated"));
+    CHECK(C.find("me") == string("Yosef"));
+    CHECK(C.find("grandfather") == string("Isaac"));
+    CHECK(C.find("great-grandfather") == string("Israel"));
+    CHECK(C.tryFind("great-great-grandmother").code == status::relation_not_found);
+    CHECK(C.tryFind("grand").code == status::bad_relation);
+    CHECK_THROWS(C.find("great-great-grandmother"));
+
+    Tree R ("Yosef"); // The second Ruti is added later but comes first in preorder.
+    R.addFather("Yosef", "Yaakov").addMother("Yosef", "Rachel").addMother("Rachel", "Ruti")
+     .addFather("Yaakov", "Isaac").addMother("Isaac", "Ruti").addFather("Rachel", "Ruti");
+    CompactTree E (R);
+    CHECK(R.relation("Ruti") == string("great-grandmother"));
+    CHECK(E.relation("Ruti") == R.relation("Ruti"));
+    CHECK(E.relationOf(E.search("Ruti")).depth == 3);
+
+    Tree L ("p1"); // 127 people: repeated leaf names in full fingerprint blocks and in the tail.
+    for(int k = 1; k < 64; k++){
+        string father = k < 32 ? "p" + to_string(2*k) : "leaf" + to_string((2*k) % 5);
+        string mother = k < 32 ? "p" + to_string(2*k + 1) : "leaf" + to_string((2*k + 1) % 5);
+        if(k == 63){
+            father = mother = "tail"; // Only in the last, partial block.
+        }
+        L.addFather("p" + to_string(k), father).addMother("p" + to_string(k), mother);
+    }
+    CompactTree F (L);
+    CHECK(F.size() == 127);
+    for(int leaf = 0; leaf < 5; leaf++){
+        string name = "leaf" + to_string(leaf);
+        CHECK(F.relation(name) == L.relation(name));
+        CHECK(F.nameOf(F.search(name)) == name);
+    }
+    CHECK(F.relation("tail") == L.relation("tail"));
+    CHECK(F.search("tail") == F.size() - 2);
+    CHECK(F.search("leaf5") == CompactTree::NONE);
+
+    pedigree input = sparsePedigree(3000, 11);
+    Tree S (input.root);
+    replay(input, S);
+    CompactTree D (S);
+    CHECK(D.size() == 3000);
+    size_t mismatches = 0;
+    for(const operation &op : input.operations){
+        mismatches += D.relation(op.name) != S.relation(op.name);
+    }
+    for(int depth = 0; depth < 30; depth++){
+        for(position pos : {father_pos, mother_pos}){
+            relation_data data = {true, depth, depth == 0 ? self : pos};
+            string relation = relationToString(data);
+            mismatches += D.tryFind(relation).name != S.tryFind(relation).name;
+        }
+    }
+    CHECK(mismatches == 0);
+}
@@ -0,0 +1,121 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "FamilyTree.hpp"
+using namespace std;
+
+namespace family{
+    /*
+    * NodeStack - the explicit stack of a traversal. The first INLINE_SIZE entries live inside the object,
+    * deeper entries spill to the heap, so ordinary traversals never allocate.
+    */
+    class NodeStack{
+    private:
+        static const size_t INLINE_SIZE = 64;
+        node *inlined[INLINE_SIZE];
+        size_t count = 0;
+        vector<node*> spill;
+
+    public:
+        bool empty() const {
+            return count == 0;
+        }
+
+        void push(node *n){
+            if(count < INLINE_SIZE){
+                inlined[count] = n;
+            }else{
+                spill.push_back(n);
+            }
+            count++;
+        }
+
+        node* pop(){
+            count--;
+            if(count < INLINE_SIZE){
+                return inlined[count];
+            }
+            node *top = spill.back();
+            spill.pop_back();
+            return top;
+        }
+    };
+
+    /*
+    * loadLink - reads a father/mother link with an acquire load. ConcurrentTree publishes new parents by a compare
+    * and swap while the tree is read, so traversals never read the links plainly (an ordinary load on x86).
+    */
+    inline node* loadLink(node *const &link){
+        return atomic_ref<node*>(const_cast<node*&>(link)).load(memory_order_acquire);
+    }
+
+    /*
+    * preorder - visits a subtree in preorder (a person, then his father's side, then his mother's side) without recursion.
+    * The father and mother of a person are pushed before the person is visited, so the visitor may release the node.
+    * param 1: root - the subtree root (may be NULL).
+    * param 2: maxDepth - people deeper than this depth (see node::depth) are not visited.
+    * param 3: visit - called with every node, returns true to stop the traversal.
+    * return value: node* - the node at which the traversal stopped Or NULL if every node was visited.
+    */
+    template<typename Visitor>
+    node* preorder(node *root, int maxDepth, Visitor visit){
+        NodeStack stack;
+        if(root != NULL && root->depth <= maxDepth){
+            stack.push(root);
+        }
+        while(!stack.empty()){
+            node *current = stack.pop();
+            if(current->depth < maxDepth){
+                node *mother = loadLink(current->mother);
+                node *father = loadLink(current->father);
+                if(mother != NULL){
+                    stack.push(mother);
+                }
+                if(father != NULL){
+                    stack.push(father);
+                }
+            }
+            if(visit(current)){
+                return current;
+            }
+        }
+        return NULL;
+    }
+
+    template<typename Visitor>
+    node* preorder(node *root, Visitor visit){
+        return preorder(root, INT_MAX, visit);
+    }
+
+    /*
+    * numberedPreorder - a preorder walk which numbers the people as it goes (the root is 0).
+    * In preorder the last person visited one generation below a person is his child, so the numbers of the
+    * current line are enough to give every person the number of his child.
+    * param 1: root - the subtree root (may be NULL).
+    * param 2: visit - called with every node, its preorder number and the number of its child (0 for the root).
+    */
+    template<typename Visitor>
+    void numberedPreorder(node *root, Visitor visit){
+        if(root == NULL){
+            return;
+        }
+        vector<uint64_t> line; // line[i] - the number of the last person visited i generations above the root.
+        uint64_t next = 0;
+        preorder(root, [root, &visit, &line, &next](node *person){
+            size_t generation = person->depth - root->depth;
+            if(line.size() <= generation){
+                line.resize(generation + 1);
+            }
+            line[generation] = next++;
+            visit(person, line[generation], generation == 0 ? 0 : line[generation - 1]);
+            return false;
+        });
+    }
+}
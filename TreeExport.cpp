@@ -0,0 +1,53 @@
+#include "FamilyTree.hpp"
+#include "OutputBuffer.hpp"
+#include "Traversal.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* exportDot - writes the tree as a Graphviz digraph. people are numbered in preorder (the root is 0)
+* and every edge goes from a parent to its child, labeled "father" or "mother".
+* param 1: out - the output stream (not flushed).
+*/
+void Tree::exportDot(ostream &out) const{
+    OutputBuffer text(out);
+    text << "digraph family {\n";
+    numberedPreorder(root, [this, &text](node *person, uint64_t number, uint64_t child){
+        text << "  " << number << " [label=";
+        text.dotQuoted(nameOf(person)) << "];\n";
+        if(person->child != NULL){
+            text << "  " << number << " -> " << child << " [label=" << (person->pos == father_pos ? "father" : "mother") << "];\n";
+        }
+    });
+    text << "}\n";
+}
+
+/*
+* exportJsonLines - writes one JSON object per person, in preorder (the root is id 0):
+*   {"id": 1, "name": "Yaakov", "child": 0, "relation": "father"}
+* the child of the root is null.
+* param 1: out - the output stream (not flushed).
+*/
+void Tree::exportJsonLines(ostream &out) const{
+    OutputBuffer text(out);
+    char relation[256];
+    numberedPreorder(root, [this, &text, &relation](node *person, uint64_t number, uint64_t child){
+        text << "{\"id\": " << number << ", \"name\": ";
+        text.quoted(nameOf(person)) << ", \"child\": ";
+        if(person->child != NULL){
+            text << child;
+        }else{
+            text << "null";
+        }
+        relation_data data = {true, person->depth, person->pos};
+        size_t length = writeRelation(data, relation, sizeof(relation));
+        text << ", \"relation\": \"";
+        if(length < sizeof(relation)){
+            text << string_view(relation, length);
+        }else{
+            text << relationToString(data); // Only for very deep generations.
+        }
+        text << "\"}\n";
+    });
+}
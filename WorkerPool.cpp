@@ -0,0 +1,80 @@
+#include "WorkerPool.hpp"
+
+using namespace std;
+using namespace family;
+
+/*
+* Destructor - stops the workers (after the running job, if any) and joins them.
+*/
+WorkerPool::~WorkerPool(){
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(thread &worker : workers){
+        worker.join();
+    }
+}
+
+/*
+* shared - the pool of the process, whose threads are started by the first parallel search.
+*/
+WorkerPool& WorkerPool::shared(){
+    static WorkerPool pool;
+    return pool;
+}
+
+/*
+* work - the loop of a worker: waits for a job it didn't take yet and runs it.
+*/
+void WorkerPool::work(){
+    uint64_t seen = 0;
+    unique_lock<mutex> guard(lock);
+    while(true){
+        wake.wait(guard, [this, &seen](){ return stopping || (pending > 0 && generation != seen); });
+        if(stopping){
+            return;
+        }
+        seen = generation;
+        pending--;
+        active++;
+        const function<void()> *current = job;
+        guard.unlock();
+        (*current)();
+        guard.lock();
+        if(--active == 0){
+            done.notify_all();
+        }
+    }
+}
+
+/*
+* run - runs a job on the calling thread and on up to 'helpers' workers, and returns when every one of them is done.
+* The pool starts the workers it is missing, so it grows to the most helpers ever asked for.
+* param 1: helpers - the number of threads besides the caller.
+* param 2: job - a loop over shared tasks (it must be done when the caller's call returns, except for the tasks
+*                other threads already took).
+*/
+void WorkerPool::run(size_t helpers, const function<void()> &job){
+    unique_lock<mutex> exclusive(busy, try_to_lock);
+    if(helpers == 0 || !exclusive.owns_lock()){
+        job();
+        return;
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        while(workers.size() < helpers){
+            workers.emplace_back(&WorkerPool::work, this);
+        }
+        this->job = &job;
+        pending = helpers;
+        generation++;
+    }
+    wake.notify_all();
+    job();
+    unique_lock<mutex> guard(lock);
+    pending = 0; // The tasks are all taken, helpers which didn't start yet have nothing to do.
+    done.wait(guard, [this](){ return active == 0; });
+    this->job = NULL;
+}
@@ -0,0 +1,50 @@
+//
+// Created by user on 12/04/2020.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace family{
+    /*
+    * WorkerPool - threads which are started once and then kept waiting for jobs, so a parallel search doesn't pay
+    * for creating and joining its threads on every call.
+    * A job is a loop which takes tasks from a shared counter until there are none left: run() runs it on the caller
+    * and on helper threads, and helpers which didn't start before the caller finished are simply not used.
+    * One job runs at a time. A run() which finds the pool busy runs its job on the caller alone.
+    */
+    class WorkerPool{
+    private:
+        /*Private variables*/
+        mutex busy;                          // Held by the run() whose job the workers take.
+        mutex lock;                          // Guards the fields below.
+        condition_variable wake;             // A job was posted, or the pool is stopping.
+        condition_variable done;             // The last helper finished its share.
+        vector<thread> workers;
+        const function<void()> *job = NULL;
+        size_t pending = 0;                  // Helpers the current job may still take.
+        size_t active = 0;                   // Helpers running the current job.
+        uint64_t generation = 0;             // Counts the posted jobs, so a worker takes every job once.
+        bool stopping = false;
+
+        /*Private methods*/
+        void work();
+
+    public:
+        WorkerPool() = default;
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        static WorkerPool& shared();
+        void run(size_t helpers, const function<void()> &job);
+    };
+}
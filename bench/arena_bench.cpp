@@ -0,0 +1,70 @@
+/**
+ * Benchmark - building and destroying a full pedigree with per-person new/delete
+ * versus the chunked node arena that family::Tree uses.
+ *
+ * Usage: ./bench_arena [people]
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../FamilyTree.hpp"
+
+using namespace std;
+using namespace family;
+using Clock = chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point start){
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+static void freeHeap(node *root){
+    if(root != NULL){
+        freeHeap(root->father);
+        freeHeap(root->mother);
+        delete root;
+    }
+}
+
+/* Links people Ahnentafel style: the father of person k is 2k, the mother is 2k+1. */
+static void link(vector<node*> &people){
+    for(size_t k = 1; k < people.size(); k++){
+        if(2*k < people.size()) people[k]->father = people[2*k];
+        if(2*k+1 < people.size()) people[k]->mother = people[2*k+1];
+    }
+}
+
+int main(int argc, char **argv){
+    size_t people = argc > 1 ? stoul(argv[1]) : 1000000;
+    vector<node*> byNumber(people + 1, NULL);
+    SymbolTable names;
+    uint32_t name = names.intern(string_view("person"));
+
+    Clock::time_point start = Clock::now();
+    for(size_t k = 1; k <= people; k++){
+        byNumber[k] = new node(name);
+    }
+    link(byNumber);
+    double heapBuild = elapsedMs(start);
+    start = Clock::now();
+    freeHeap(byNumber[1]);
+    double heapDestroy = elapsedMs(start);
+
+    start = Clock::now();
+    NodeArena *arena = new NodeArena();
+    for(size_t k = 1; k <= people; k++){
+        byNumber[k] = arena->allocate(name);
+    }
+    link(byNumber);
+    double arenaBuild = elapsedMs(start);
+    start = Clock::now();
+    delete arena;
+    double arenaDestroy = elapsedMs(start);
+
+    cout << "people:        " << people << "\n";
+    cout << "new/delete:    build " << heapBuild << " ms, destroy " << heapDestroy << " ms\n";
+    cout << "arena:         build " << arenaBuild << " ms, destroy " << arenaDestroy << " ms\n";
+    cout << "speedup:       build x" << heapBuild / arenaBuild << ", destroy x" << heapDestroy / arenaDestroy << endl;
+    return 0;
+}
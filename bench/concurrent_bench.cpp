@@ -0,0 +1,256 @@
+/**
+ * Benchmark - query throughput of family::ConcurrentTree with 1 .. N reader threads,
+ * in both reclamation modes, next to the same tree behind one global mutex, with and without a writer thread,
+ * and the throughput of building a tree with 1 .. N ingest threads in both insertion modes.
+ * The readers query by name (relation into a buffer) or by relation (tryFind, which the epoch mode runs without
+ * the lock). The writer keeps adding a branch of BRANCH people and removing it, and its removes are timed.
+ * The results are written to stdout as one JSON document:
+ *
+ *   {"benchmarks": [
+ *     {"op": "relation(buffer)" | "tryFind", "engine": "...", "people": N, "threads": N, "writer": B, "ops_per_sec": X},
+ *     {"op": "remove", "engine": "...", "people": N, "threads": N, "branch": N, "ns_per_op": X, "max_ns": X},
+ *     {"op": "addFather/addMother", "engine": "...", "people": N, "threads": N, "ops_per_sec": X}, ...]}
+ *
+ * ("threads" is the number of readers for the query and remove records, and of ingest threads for the adds).
+ *
+ * Usage: ./bench_concurrent [people] [max threads]   (default 1e6 people, hardware threads)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../FamilyTree.hpp"
+#include "../ConcurrentTree.hpp"
+#include "../Pedigree.hpp"
+
+using namespace std;
+using namespace family;
+using Clock = chrono::steady_clock;
+
+/*
+* LockedTree - the baseline: every call holds one global mutex.
+*/
+class LockedTree{
+private:
+    mutable mutex lock;
+    Tree tree;
+
+public:
+    LockedTree(string_view root) : tree(root){
+    }
+
+    void addFather(string_view to, string_view name){
+        lock_guard<mutex> writing(lock);
+        tree.addFather(to, name);
+    }
+
+    void addMother(string_view to, string_view name){
+        lock_guard<mutex> writing(lock);
+        tree.addMother(to, name);
+    }
+
+    void remove(string_view name){
+        lock_guard<mutex> writing(lock);
+        tree.remove(name);
+    }
+
+    size_t relation(string_view who, char *buffer, size_t size) const{
+        lock_guard<mutex> reading(lock);
+        return tree.relation(who, buffer, size);
+    }
+    find_result tryFind(string_view relation) const{
+        lock_guard<mutex> reading(lock);
+        return tree.tryFind(relation);
+    }
+};
+
+/* Builds a full pedigree named p1 ... p<people>. */
+template<typename T>
+static void build(T &tree, size_t people){
+    for(size_t k = 1; 2*k <= people; k++){
+        tree.addFather("p" + to_string(k), "p" + to_string(2*k));
+        if(2*k + 1 <= people){
+            tree.addMother("p" + to_string(k), "p" + to_string(2*k + 1));
+        }
+    }
+}
+
+static const size_t BRANCH = 127; // People in the branch the writer adds and removes.
+
+/*
+* run_result - the queries per second of the readers, and the latency of the writer's removes.
+*/
+struct run_result {
+    double opsPerSec = 0;
+    double removeNs = 0;
+    double removeMaxNs = 0;
+};
+
+/*
+* measure - runs 'threads' readers for a fixed time, optionally next to a writer which keeps adding a branch of BRANCH
+* people above one of the oldest people and removing it, and returns the total number of queries per second
+* and the mean and worst time of a remove.
+* queries - the names to find relations of, or the relations to find (byRelation).
+*/
+template<typename T>
+static run_result measure(T &tree, size_t people, const vector<string> &queries, bool byRelation, size_t threads, bool writer){
+    const chrono::milliseconds duration(300);
+    atomic<bool> done(false);
+    atomic<size_t> total(0);
+    vector<thread> readers;
+    for(size_t t = 0; t < threads; t++){
+        readers.emplace_back([&tree, &queries, byRelation, &done, &total, t](){
+            char buffer[256];
+            size_t ops = 0, checksum = 0;
+            for(size_t i = t * 7919; !done.load(memory_order_relaxed); i++, ops++){
+                const string &query = queries[i % queries.size()];
+                checksum += byRelation ? tree.tryFind(query).name.size() : tree.relation(query, buffer, sizeof(buffer));
+            }
+            total += checksum == 0 ? 0 : ops;
+        });
+    }
+    run_result result;
+    thread writing;
+    if(writer){
+        writing = thread([&tree, &done, &result, people](){
+            size_t removes = 0;
+            double sum = 0;
+            for(size_t i = 0; !done.load(memory_order_relaxed); i++){
+                // w<i>-1 is the father of a leaf, w<i>-k the father/mother of w<i>-(k/2).
+                string prefix = "w" + to_string(i) + "-";
+                tree.addFather("p" + to_string(people - i % (people / 2)), prefix + "1");
+                for(size_t k = 2; k <= BRANCH; k++){
+                    if(k % 2 == 0){
+                        tree.addFather(prefix + to_string(k / 2), prefix + to_string(k));
+                    }else{
+                        tree.addMother(prefix + to_string(k / 2), prefix + to_string(k));
+                    }
+                }
+                Clock::time_point start = Clock::now();
+                tree.remove(prefix + "1");
+                double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+                sum += ns;
+                result.removeMaxNs = max(result.removeMaxNs, ns);
+                removes++;
+            }
+            result.removeNs = removes == 0 ? 0 : sum / removes;
+        });
+    }
+    Clock::time_point start = Clock::now();
+    this_thread::sleep_for(duration);
+    done = true;
+    for(thread &reader : readers){
+        reader.join();
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    if(writer){
+        writing.join();
+    }
+    result.opsPerSec = total / seconds;
+    return result;
+}
+
+/*
+* ingest - builds a full pedigree of 'people' with 'threads' ingest threads and returns the adds per second.
+* The top of the pedigree is built first, then every thread fills the pedigrees above its own share of its leaves.
+*/
+static double ingest(insertion adding, size_t people, size_t threads){
+    ConcurrentTree tree ("p1", storage::linked, reclamation::immediate, adding);
+    size_t top = 1;
+    while(top < threads){
+        top *= 2;
+    }
+    build(tree, min(people, 2*top - 1));
+    Clock::time_point start = Clock::now();
+    vector<thread> workers;
+    for(size_t t = 0; t < threads; t++){
+        workers.emplace_back([&tree, people, top, threads, t](){
+            for(size_t first = top + t; first < 2*top; first += threads){
+                // The people above 'first' level by level: first*2^d ... first*2^d + 2^d - 1.
+                for(size_t level = first, width = 1; 2*level <= people; level *= 2, width *= 2){
+                    for(size_t k = level; k < level + width && 2*k <= people; k++){
+                        tree.addFather("p" + to_string(k), "p" + to_string(2*k));
+                        if(2*k + 1 <= people){
+                            tree.addMother("p" + to_string(k), "p" + to_string(2*k + 1));
+                        }
+                    }
+                }
+            }
+        });
+    }
+    for(thread &worker : workers){
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    return (people - min(people, 2*top - 1)) / seconds;
+}
+
+int main(int argc, char **argv){
+    size_t people = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t maxThreads = argc > 2 ? stoul(argv[2]) : max(1u, thread::hardware_concurrency());
+    ConcurrentTree shared ("p1");
+    ConcurrentTree epoch ("p1", storage::linked, reclamation::epoch);
+    LockedTree locked ("p1");
+    build(shared, people);
+    build(epoch, people);
+    build(locked, people);
+    vector<size_t> threadCounts;
+    for(size_t threads = 1; threads < maxThreads; threads *= 2){
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    mt19937_64 random(people);
+    vector<string> names(100000);
+    for(string &name : names){
+        name = "p" + to_string(1 + random() % people);
+    }
+    int generations = 0;
+    while(((size_t)2 << generations) <= people){
+        generations++;
+    }
+    vector<string> relations(1000);
+    for(string &relation : relations){
+        int depth = 1 + random() % generations;
+        relation = relationToString({true, depth, random() % 2 ? father_pos : mother_pos});
+    }
+
+    cout << "{\"benchmarks\": [";
+    bool first = true;
+    for(bool writer : {false, true}){
+        for(size_t threads : threadCounts){
+            for(bool byRelation : {false, true}){
+                run_result sharedRun = measure(shared, people, byRelation ? relations : names, byRelation, threads, writer);
+                run_result epochRun = measure(epoch, people, byRelation ? relations : names, byRelation, threads, writer);
+                run_result lockedRun = measure(locked, people, byRelation ? relations : names, byRelation, threads, writer);
+                for(auto result : {make_pair("concurrent", sharedRun), make_pair("concurrent epoch", epochRun),
+                                   make_pair("global mutex", lockedRun)}){
+                    cout << (first ? "\n" : ",\n") << "  {\"op\": \"" << (byRelation ? "tryFind" : "relation(buffer)")
+                         << "\", \"engine\": \"" << result.first << "\", \"people\": " << people << ", \"threads\": " << threads
+                         << ", \"writer\": " << (writer ? "true" : "false") << ", \"ops_per_sec\": " << result.second.opsPerSec << "}";
+                    first = false;
+                    if(writer){
+                        cout << ",\n  {\"op\": \"remove\", \"engine\": \"" << result.first << "\", \"people\": " << people
+                             << ", \"threads\": " << threads << ", \"branch\": " << BRANCH << ", \"ns_per_op\": " << result.second.removeNs
+                             << ", \"max_ns\": " << result.second.removeMaxNs << "}";
+                    }
+                }
+            }
+        }
+    }
+    for(size_t threads : threadCounts){
+        double exclusiveRate = ingest(insertion::exclusive, people, threads);
+        double concurrentRate = ingest(insertion::concurrent, people, threads);
+        for(auto result : {make_pair("concurrent", exclusiveRate), make_pair("concurrent adds", concurrentRate)}){
+            cout << ",\n  {\"op\": \"addFather/addMother\", \"engine\": \"" << result.first << "\", \"people\": " << people
+                 << ", \"threads\": " << threads << ", \"ops_per_sec\": " << result.second << "}";
+        }
+    }
+    cout << "\n]}" << endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * Micro benchmark - parsing relation strings with family::parseRelation and rendering
+ * them back with family::writeRelation. Global operator new is replaced to count heap
+ * allocations made on both paths.
+ *
+ * Usage: ./bench_parse [iterations]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include "../Relation.hpp"
+
+using namespace std;
+using namespace family;
+using Clock = chrono::steady_clock;
+
+static size_t allocations = 0;
+
+void* operator new(size_t size){
+    allocations++;
+    void *p = malloc(size == 0 ? 1 : size);
+    if(p == NULL){
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept{
+    free(p);
+}
+
+int main(int argc, char **argv){
+    size_t iterations = argc > 1 ? stoul(argv[1]) : 10000000;
+    const string_view inputs[] = {"me", "mother", "grandfather", "great-great-great-great-grandmother", "great-grandfatrher"};
+    const size_t count = sizeof(inputs) / sizeof(inputs[0]);
+
+    long checksum = 0;
+    size_t before = allocations;
+    Clock::time_point start = Clock::now();
+    for(size_t i = 0; i < iterations; i++){
+        relation_data data = parseRelation(inputs[i % count]);
+        checksum += data.valid ? data.depth : -1;
+    }
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+    size_t parseAllocations = allocations - before;
+
+    char buffer[64];
+    before = allocations;
+    start = Clock::now();
+    for(size_t i = 0; i < iterations; i++){
+        relation_data data = parseRelation(inputs[i % count]);
+        checksum += writeRelation(data, buffer, sizeof(buffer));
+    }
+    double renderNs = chrono::duration<double, nano>(Clock::now() - start).count();
+    size_t renderAllocations = allocations - before;
+
+    cout << "parses:                    " << iterations << "\n";
+    cout << "ns/parse:                  " << ns / iterations << "\n";
+    cout << "allocations/parse:         " << (double)parseAllocations / iterations << "\n";
+    cout << "ns/parse+render:           " << renderNs / iterations << "\n";
+    cout << "allocations/parse+render:  " << (double)renderAllocations / iterations << "\n";
+    cout << "checksum:                  " << checksum << endl;
+    return parseAllocations == 0 && renderAllocations == 0 ? 0 : 1;
+}
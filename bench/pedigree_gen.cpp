@@ -0,0 +1,61 @@
+/**
+ * pedigree_gen - writes a synthetic pedigree as an operation script (see family::writeScript).
+ *
+ * Usage: ./pedigree_gen full <depth>
+ *        ./pedigree_gen chain <generations> [father|mother]
+ *        ./pedigree_gen sparse <people> [seed]
+ *        ./pedigree_gen collapse <people> <repeat rate> [seed]
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../Pedigree.hpp"
+
+using namespace std;
+using namespace family;
+
+static int usage(){
+    cerr << "usage: pedigree_gen full <depth>\n"
+         << "       pedigree_gen chain <generations> [father|mother]\n"
+         << "       pedigree_gen sparse <people> [seed]\n"
+         << "       pedigree_gen collapse <people> <repeat rate> [seed]" << endl;
+    return 2;
+}
+
+int main(int argc, char **argv){
+    if(argc < 3){
+        return usage();
+    }
+    string shape = argv[1];
+    pedigree output;
+    try{ // Malformed numbers throw invalid_argument / out_of_range, as do the generators for bad parameters.
+        size_t size = stoul(argv[2]);
+        if(shape == "full"){
+            if(size > (size_t)AhnentafelIndex::MAX_DEPTH){
+                cerr << "pedigree_gen: full pedigree depth must be at most " << AhnentafelIndex::MAX_DEPTH << endl;
+                return 2;
+            }
+            output = fullPedigree((int)size);
+        }else if(shape == "chain"){
+            position side = argc > 3 && string(argv[3]) == "mother" ? mother_pos : father_pos;
+            output = chainPedigree(size, side);
+        }else if(shape == "sparse"){
+            output = sparsePedigree(size, argc > 3 ? stoull(argv[3]) : 1);
+        }else if(shape == "collapse" && argc > 3){
+            output = collapsedPedigree(size, stod(argv[3]), argc > 4 ? stoull(argv[4]) : 1);
+        }else{
+            return usage();
+        }
+    }catch(const invalid_argument &error){
+        cerr << "pedigree_gen: bad argument (" << error.what() << ")" << endl;
+        return usage();
+    }catch(const out_of_range &error){
+        cerr << "pedigree_gen: bad argument (" << error.what() << ")" << endl;
+        return usage();
+    }
+    ios::sync_with_stdio(false);
+    writeScript(output, cout);
+    cout.flush();
+    return 0;
+}
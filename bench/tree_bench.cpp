@@ -0,0 +1,383 @@
+/**
+ * Benchmark suite - every family::Tree operation on full binary pedigrees of growing size.
+ * Global operator new is replaced to count heap allocations, and the results are written
+ * to stdout as one JSON document:
+ *
+ *   {"benchmarks": [{"op": "...", "engine": "...", "people": N, "ops": N, "ns_per_op": X, "ops_per_sec": X, "allocs_per_op": X}, ...]}
+ *
+ * The scaling of the parallel search is reported in records of their own, one per thread count
+ * (speedup is the time of the sequential search divided by this one):
+ *
+ *   {"op": "find(miss) scaling", "engine": "linked", "people": N, "threads": N, "ns_per_op": X, "speedup": X}
+ *
+ * Usage: ./bench_tree [max people]   (sizes are 1e3, 1e4, ... up to max people, default 1e6)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../FamilyTree.hpp"
+#include "../Pedigree.hpp"
+#include "../CompactTree.hpp"
+#include "../MappedTree.hpp"
+
+using namespace std;
+using namespace family;
+using Clock = chrono::steady_clock;
+
+static atomic<size_t> allocations(0); // The parallel search's pool threads allocate too.
+
+void* operator new(size_t size){
+    allocations.fetch_add(1, memory_order_relaxed);
+    void *p = malloc(size == 0 ? 1 : size);
+    if(p == NULL){
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept{
+    free(p);
+}
+
+/*
+* Measurement - times a phase and counts the heap allocations made during it.
+*/
+class Measurement{
+private:
+    Clock::time_point start;
+    size_t allocationsBefore;
+
+public:
+    Measurement(){
+        allocationsBefore = allocations.load(memory_order_relaxed);
+        start = Clock::now();
+    }
+
+    double ns() const {
+        return chrono::duration<double, nano>(Clock::now() - start).count();
+    }
+
+    size_t allocs() const {
+        return allocations.load(memory_order_relaxed) - allocationsBefore;
+    }
+};
+
+/*
+* JsonReport - writes the benchmark records as a single JSON document.
+*/
+class JsonReport{
+private:
+    bool first = true;
+
+public:
+    JsonReport(){
+        cout << "{\"benchmarks\": [";
+    }
+
+    ~JsonReport(){
+        cout << "\n]}" << endl;
+    }
+
+    void add(const string &op, const string &engine, size_t people, size_t ops, double ns, size_t allocs){
+        cout << (first ? "\n" : ",\n") << "  {\"op\": \"" << op << "\", \"engine\": \"" << engine
+             << "\", \"people\": " << people << ", \"ops\": " << ops
+             << ", \"ns_per_op\": " << (ops == 0 ? 0.0 : ns / ops)
+             << ", \"ops_per_sec\": " << (ns == 0 ? 0.0 : ops * 1e9 / ns)
+             << ", \"allocs_per_op\": " << (ops == 0 ? 0.0 : (double)allocs / ops) << "}";
+        first = false;
+    }
+
+    void addScaling(const string &op, const string &engine, size_t people, size_t threads, double nsPerOp, double speedup){
+        cout << (first ? "\n" : ",\n") << "  {\"op\": \"" << op << "\", \"engine\": \"" << engine
+             << "\", \"people\": " << people << ", \"threads\": " << threads
+             << ", \"ns_per_op\": " << nsPerOp << ", \"speedup\": " << speedup << "}";
+        first = false;
+    }
+};
+
+/*
+* NullBuffer - a stream buffer which discards everything, used to time display().
+*/
+class NullBuffer: public streambuf{
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    streamsize xsputn(const char*, streamsize n) override {
+        return n;
+    }
+};
+
+/* Builds a generated pedigree into a new tree. */
+static Tree* build(const pedigree &input, storage engine){
+    Tree *T = new Tree(input.root, engine);
+    replay(input, *T);
+    return T;
+}
+
+/* The people of a full pedigree named p1 ... p<people> (the last generation may be partial). */
+static pedigree fullPedigreeOf(size_t people){
+    int depth = 0;
+    while((size_t(2) << depth) - 1 < people){
+        depth++;
+    }
+    pedigree input = fullPedigree(depth);
+    input.operations.resize(people - 1);
+    return input;
+}
+
+/* The compact copy answers every query with a sequential scan, so keep its total work near 1e8 visited people. */
+static void benchmarkCompact(JsonReport &report, const Tree &T, const vector<string> &names, const vector<size_t> &picks, const vector<string> &relations){
+    Measurement copying;
+    CompactTree C (T);
+    size_t people = C.size();
+    report.add("compact(copy)", "compact", people, people, copying.ns(), copying.allocs());
+
+    size_t queries = max<size_t>(10, min<size_t>(picks.size(), 100000000 / people));
+    size_t checksum = 0;
+    char buffer[256];
+    Measurement relating;
+    for(size_t i = 0; i < queries; i++){
+        checksum += C.relation(names[picks[i]], buffer, sizeof(buffer));
+    }
+    report.add("relation(buffer)", "compact", people, queries, relating.ns(), relating.allocs());
+
+    Measurement finding;
+    for(size_t i = 0; i < queries; i++){
+        checksum += C.tryFind(relations[i % relations.size()]).name.size();
+    }
+    report.add("find", "compact", people, queries, finding.ns(), finding.allocs());
+    if(checksum == 0){
+        cerr << "unexpected checksum" << endl;
+    }
+}
+
+static void benchmark(JsonReport &report, size_t people, storage engine){
+    const string engineName = engine == storage::linked ? "linked" : "ahnentafel";
+    const size_t queries = 100000;
+    mt19937_64 random(people);
+    pedigree input = fullPedigreeOf(people);
+    vector<string> names(people + 1);
+    for(size_t k = 1; k <= people; k++){
+        names[k] = "p" + to_string(k);
+    }
+
+    // Build and destroy - repeated so every size adds at least a million people.
+    size_t reps = people >= 1000000 ? 1 : 1000000 / people;
+    double buildNs = 0, destroyNs = 0;
+    size_t buildAllocs = 0, destroyAllocs = 0;
+    for(size_t r = 0; r < reps; r++){
+        Measurement building;
+        Tree *T = build(input, engine);
+        buildNs += building.ns();
+        buildAllocs += building.allocs();
+        Measurement destroying;
+        delete T;
+        destroyNs += destroying.ns();
+        destroyAllocs += destroying.allocs();
+    }
+    report.add("addFather/addMother", engineName, people, reps * (people - 1), buildNs, buildAllocs);
+    report.add("destroy", engineName, people, reps * people, destroyNs, destroyAllocs);
+
+    Tree *T = build(input, engine);
+
+    vector<size_t> picks(queries);
+    for(size_t i = 0; i < queries; i++){
+        picks[i] = 1 + random() % people;
+    }
+    size_t checksum = 0;
+    Measurement relating;
+    for(size_t i = 0; i < queries; i++){
+        checksum += T->relation(names[picks[i]]).size();
+    }
+    report.add("relation", engineName, people, queries, relating.ns(), relating.allocs());
+
+    char buffer[256];
+    Measurement relatingInto;
+    for(size_t i = 0; i < queries; i++){
+        checksum += T->relation(names[picks[i]], buffer, sizeof(buffer));
+    }
+    report.add("relation(buffer)", engineName, people, queries, relatingInto.ns(), relatingInto.allocs());
+
+    // find - every relation of the pedigree, deepest generations included, half of them on the mother's side.
+    vector<string> relations;
+    relation_data data;
+    data.valid = true;
+    for(data.depth = 0; (size_t(1) << data.depth) <= people; data.depth++){
+        data.pos = data.depth == 0 ? self : father_pos;
+        relations.push_back(relationToString(data));
+        data.pos = data.depth == 0 ? self : mother_pos;
+        relations.push_back(relationToString(data));
+    }
+    // The linked engine answers find() with a depth limited search, so keep its total work near 1e7 visited people.
+    size_t findQueries = engine == storage::linked ? max<size_t>(10, 10000000 / people) : queries;
+    Measurement finding;
+    for(size_t i = 0; i < findQueries; i++){
+        find_result found = T->tryFind(relations[i % relations.size()]);
+        checksum += found.name.size();
+    }
+    report.add("find", engineName, people, findQueries, finding.ns(), finding.allocs());
+
+    // findAll - the same relations answered a whole batch at a time.
+    vector<string_view> batch(relations.begin(), relations.end());
+    size_t batches = max<size_t>(1, findQueries / batch.size());
+    Measurement findingAll;
+    for(size_t i = 0; i < batches; i++){
+        checksum += T->findAll(batch).back().name.size();
+    }
+    report.add("findAll", engineName, people, batches * batch.size(), findingAll.ns(), findingAll.allocs());
+
+    const string missed = "great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-great-grandmother";
+    Measurement missing;
+    for(size_t i = 0; i < findQueries; i++){
+        checksum += T->tryFind(missed).name.size();
+    }
+    report.add("find(miss)", engineName, people, findQueries, missing.ns(), missing.allocs());
+
+    // find(miss, parallel) - the same whole tree search, the linked engine searching large trees on every hardware thread.
+    Measurement missingParallel;
+    for(size_t i = 0; i < findQueries; i++){
+        checksum += T->tryFind(missed, 0).name.size();
+    }
+    report.add("find(miss, parallel)", engineName, people, findQueries, missingParallel.ns(), missingParallel.allocs());
+
+    // find(miss) scaling - the parallel search on 1, 2, 4 ... threads, up to twice the hardware threads.
+    if(engine == storage::linked){
+        double sequentialNs = 0;
+        size_t maxThreads = 2 * max(1u, thread::hardware_concurrency());
+        for(size_t threads = 1; threads <= maxThreads; threads *= 2){
+            Measurement scaling;
+            for(size_t i = 0; i < findQueries; i++){
+                checksum += T->tryFind(missed, threads).name.size();
+            }
+            double nsPerOp = scaling.ns() / findQueries;
+            if(threads == 1){
+                sequentialNs = nsPerOp;
+            }
+            report.addScaling("find(miss) scaling", engineName, people, threads, nsPerOp, sequentialNs / nsPerOp);
+        }
+    }
+
+    NullBuffer discard;
+    streambuf *original = cout.rdbuf(&discard);
+    Measurement displaying;
+    T->display();
+    double displayNs = displaying.ns();
+    size_t displayAllocs = displaying.allocs();
+    cout.rdbuf(original);
+    report.add("display", engineName, people, people, displayNs, displayAllocs);
+
+    ostream discarded(&discard);
+    Measurement dotting;
+    T->exportDot(discarded);
+    report.add("exportDot", engineName, people, people, dotting.ns(), dotting.allocs());
+    Measurement jsoning;
+    T->exportJsonLines(discarded);
+    report.add("exportJsonLines", engineName, people, people, jsoning.ns(), jsoning.allocs());
+
+    if(engine == storage::linked){
+        benchmarkCompact(report, *T, names, picks, relations);
+    }
+
+    // remove - prune the oldest half of the pedigree one person at a time.
+    size_t removals = 0;
+    Measurement removing;
+    for(size_t k = people; k > people / 2 && removals < queries; k--, removals++){
+        T->remove(names[k]);
+    }
+    report.add("remove", engineName, people, removals, removing.ns(), removing.allocs());
+
+    // remove(branch) - prune the father's side, about half of the tree, in one call.
+    Measurement pruning;
+    T->remove(names[2]);
+    report.add("remove(branch)", engineName, people, 1, pruning.ns(), pruning.allocs());
+
+    delete T;
+    if(checksum == 0){
+        cerr << "unexpected checksum" << endl;
+    }
+}
+
+/* Building and destroying the other generated shapes. */
+static void benchmarkShapes(JsonReport &report, size_t people){
+    const pair<string, pedigree> shapes[] = {
+        {"build(chain)", chainPedigree(people - 1)},
+        {"build(sparse)", sparsePedigree(people, 1)},
+        {"build(collapse)", collapsedPedigree(people, 0.3, 1)},
+    };
+    for(const pair<string, pedigree> &shape : shapes){
+        Measurement building;
+        Tree *T = build(shape.second, storage::linked);
+        report.add(shape.first, "linked", people, shape.second.operations.size(), building.ns(), building.allocs());
+        delete T;
+    }
+}
+
+/* Loading a full pedigree from an edge list file (ops are rows), and saving / loading it as a binary snapshot. */
+static void benchmarkLoad(JsonReport &report, size_t people){
+    string path = (filesystem::temp_directory_path() / "bench_tree.csv").string();
+    ofstream file(path, ios::binary);
+    writeCsv(fullPedigreeOf(people), file);
+    file.close();
+    size_t rows = people / 2;
+    Measurement loading;
+    unique_ptr<Tree> T = Tree::loadCsv(path);
+    report.add("loadCsv", "linked", people, rows, loading.ns(), loading.allocs());
+    filesystem::remove(path);
+
+    path = (filesystem::temp_directory_path() / "bench_tree.snapshot").string();
+    Measurement saving;
+    T->save(path);
+    report.add("save", "linked", people, people, saving.ns(), saving.allocs());
+    T.reset();
+    Measurement restoring;
+    T = Tree::load(path);
+    report.add("load", "linked", people, people, restoring.ns(), restoring.allocs());
+
+    Measurement mapping;
+    MappedTree M (path);
+    report.add("open", "mapped", people, 1, mapping.ns(), mapping.allocs());
+    size_t queries = 100000;
+    size_t checksum = 0;
+    char buffer[256];
+    mt19937_64 random(people);
+    vector<string> names(queries);
+    for(string &name : names){
+        name = "p" + to_string(1 + random() % people);
+    }
+    Measurement relating;
+    for(const string &name : names){
+        checksum += M.relation(name, buffer, sizeof(buffer));
+    }
+    report.add("relation(buffer)", "mapped", people, queries, relating.ns(), relating.allocs());
+    if(checksum == 0){
+        cerr << "unexpected checksum" << endl;
+    }
+    filesystem::remove(path);
+}
+
+int main(int argc, char **argv){
+    size_t maxPeople = argc > 1 ? stoul(argv[1]) : 1000000;
+    JsonReport report;
+    for(size_t people = 1000; people <= maxPeople; people *= 10){
+        benchmark(report, people, storage::linked);
+        benchmark(report, people, storage::ahnentafel);
+        benchmarkShapes(report, people);
+        benchmarkLoad(report, people);
+    }
+    return 0;
+}